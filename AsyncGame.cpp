@@ -0,0 +1,122 @@
+#include "AsyncGame.h"
+#include "Game.h"
+#include "Board.h"
+#include "Random.h"
+#include "StaticGame.h"
+#include "Instrument.h"
+#include <vector>
+
+using namespace std;
+
+//*********************************************************************
+//  AsyncPlayer
+//*********************************************************************
+
+bool AsyncPlayer::placeShips(Board& b)
+{
+    Task<bool> t = placeShipsAsync(b);
+    return syncWait(t);
+}
+
+Point AsyncPlayer::recommendAttack()
+{
+    Task<Point> t = recommendAttackAsync();
+    return syncWait(t);
+}
+
+//*********************************************************************
+//  RemotePlayer
+//*********************************************************************
+
+Task<bool> RemotePlayer::placeShipsAsync(Board& b)
+{
+    int nShips = game().nShips();
+    for (;;)
+    {
+        vector<ShipPlacement> layout = co_await m_placement.receive();
+        int placed = 0;
+        while (placed < nShips && placed < int(layout.size()) &&
+               b.placeShip(layout[placed].topOrLeft, placed, layout[placed].dir))
+            placed++;
+        if (placed == nShips)
+            co_return true;
+          // Take back the ships that fit and wait for another layout
+        while (placed > 0)
+        {
+            placed--;
+            b.unplaceShip(layout[placed].topOrLeft, placed, layout[placed].dir);
+        }
+    }
+}
+
+Task<Point> RemotePlayer::recommendAttackAsync()
+{
+    co_return co_await m_attack.receive();
+}
+
+void RemotePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId)
+{
+    m_lastShot.p = p;
+    m_lastShot.validShot = validShot;
+    m_lastShot.shotHit = shotHit;
+    m_lastShot.shipDestroyed = shipDestroyed;
+    m_lastShot.shipId = shipId;
+}
+
+//*********************************************************************
+//  playAsync
+//*********************************************************************
+
+Task<GameResult> playAsync(const Game& g, Player* p1, Player* p2, uint64_t seed,
+                           uint64_t gameIndex, bool recordEvents)
+{
+    GameResult result;
+    if (p1 == nullptr || p2 == nullptr || g.nShips() == 0)
+        co_return result;
+    Board b1(g);
+    Board b2(g);
+    b1.setRandomStream(RandomStream(seed, gameIndex, BOARD1_STREAM));
+    b2.setRandomStream(RandomStream(seed, gameIndex, BOARD2_STREAM));
+    p1->setRandomStream(RandomStream(seed, gameIndex, PLAYER1_STREAM));
+    p2->setRandomStream(RandomStream(seed, gameIndex, PLAYER2_STREAM));
+    p1->setDeadline(Deadline());
+    p2->setDeadline(Deadline());
+    Player* players[2] = { p1, p2 };
+    Board* boards[2] = { &b1, &b2 };
+      // Looked up once, so a computer player's move costs one test more
+      // than a direct call
+    AsyncPlayer* async[2] = { dynamic_cast<AsyncPlayer*>(p1), dynamic_cast<AsyncPlayer*>(p2) };
+
+    for (int s = 0; s < 2; s++)
+    {
+        bool placed;
+        if (async[s] != nullptr)
+            placed = co_await async[s]->placeShipsAsync(*boards[s]);
+        else
+            placed = staticgame::placeFleet(*players[s], *boards[s]);
+        result.placeRetries[s] = boards[s]->placementRetries();
+        if (!placed)
+            co_return result;
+    }
+    for (int k = 0; ; k++)
+    {
+        int a = k % 2;
+        Point p;
+        if (async[a] != nullptr)
+            p = co_await async[a]->recommendAttackAsync();
+        else
+        {
+            BSIM_PROBE(PROBE_RECOMMEND_ATTACK);
+            p = players[a]->recommendAttack();
+        }
+        if (staticgame::resolveShot(*players[a], *players[1 - a], *boards[1 - a], a, p,
+                                    result, recordEvents))
+        {
+            result.winnerIndex = a;
+            result.winner = players[a];
+            break;
+        }
+    }
+    co_return result;
+}
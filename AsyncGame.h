@@ -0,0 +1,76 @@
+#ifndef ASYNCGAME_INCLUDED
+#define ASYNCGAME_INCLUDED
+
+#include "Coroutine.h"
+#include "Player.h"
+#include "GameSink.h"
+#include "FleetGenerator.h"
+#include "globals.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class Game;
+class Board;
+
+  // A player whose moves may have to wait for something outside the
+  // program, e.g. a person at the other end of a connection.  Its moves are
+  // coroutines that suspend until their input arrives, so playAsync can
+  // leave the game parked and run other games on the same thread.  Called
+  // through the ordinary Player interface, as Game::play does, a move
+  // blocks until its input is sent from another thread.
+class AsyncPlayer : public Player
+{
+  public:
+    AsyncPlayer(std::string nm, const Game& g) : Player(nm, g) {}
+    virtual Task<bool> placeShipsAsync(Board& b) = 0;
+    virtual Task<Point> recommendAttackAsync() = 0;
+    bool placeShips(Board& b);
+    Point recommendAttack();
+};
+
+  // An AsyncPlayer driven from outside: whatever serves the participant
+  // sends it a fleet layout when wantsPlacement() and a cell when
+  // wantsAttack(), and may send either ahead of time.  A layout that
+  // doesn't fit is dropped and another is awaited, as HumanPlayer asks
+  // again for a bad placement.  The results of its shots and the
+  // opponent's shots are kept for the participant to be shown.
+class RemotePlayer : public AsyncPlayer
+{
+  public:
+    RemotePlayer(std::string nm, const Game& g) : AsyncPlayer(nm, g) {}
+    bool wantsPlacement() const { return m_placement.waiting(); }
+    bool wantsAttack() const { return m_attack.waiting(); }
+      // layout is indexed by shipId, as FleetGenerator fills it
+    void sendPlacement(const std::vector<ShipPlacement>& layout) { m_placement.send(layout); }
+    void sendAttack(Point p) { m_attack.send(p); }
+    const ShotEvent& lastShot() const { return m_lastShot; }
+    Point lastOpponentShot() const { return m_lastOpponentShot; }
+
+    Task<bool> placeShipsAsync(Board& b);
+    Task<Point> recommendAttackAsync();
+    void recordAttackResult(Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    void recordAttackByOpponent(Point p) { m_lastOpponentShot = p; }
+
+  private:
+    InputSlot<std::vector<ShipPlacement>> m_placement;
+    InputSlot<Point> m_attack;
+    ShotEvent m_lastShot;
+    Point m_lastOpponentShot;
+};
+
+  // The headless game loop as a coroutine, so that one thread can run any
+  // number of games at once: start each on a Scheduler and call runReady
+  // as input arrives.  AsyncPlayers are co_awaited, and a game waiting on
+  // one stays suspended at no cost to the others; every other player is
+  // called inline, exactly as simulateStatic would call it, so games
+  // between computer players never suspend.  Game (seed, gameIndex) draws
+  // on the streams Game::simulate would with that seed, so it plays the
+  // same game as Game::simulate without time budgets.  Time budgets,
+  // phase timing and sinks need Game::simulate.  g and the players must
+  // outlive the game.
+Task<GameResult> playAsync(const Game& g, Player* p1, Player* p2, uint64_t seed,
+                           uint64_t gameIndex, bool recordEvents = false);
+
+#endif // ASYNCGAME_INCLUDED
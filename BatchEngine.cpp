@@ -0,0 +1,378 @@
+#include "BatchEngine.h"
+#include "Game.h"
+#include "OpeningBook.h"
+#include <algorithm>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+      // Without a popcount instruction __builtin_popcountll is a library
+      // call, so count bits in registers instead: the bits set in each byte
+    uint64_t byteCounts(uint64_t x)
+    {
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        return (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    }
+
+    int countBits(uint64_t x)
+    {
+#ifdef __POPCNT__
+        return __builtin_popcountll(x);
+#else
+        return int((byteCounts(x) * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+      // Position of the set bit of x that has k set bits below it
+    int selectBit(uint64_t x, int k)
+    {
+#ifdef __BMI2__
+        return int(_tzcnt_u64(_pdep_u64(uint64_t(1) << k, x)));
+#else
+          // Byte j of below holds the bits set in bytes 0..j; skip the bytes
+          // wholly below the bit wanted, then clear bits up to it
+        uint64_t below = byteCounts(x) * 0x0101010101010101ULL;
+        int byte = 0;
+        while (byte < 7 && int((below >> (8 * byte)) & 0xff) <= k)
+            byte++;
+        if (byte > 0)
+            k -= int((below >> (8 * (byte - 1))) & 0xff);
+        uint64_t bits = (x >> (8 * byte)) & 0xff;
+        for (; k > 0; k--)
+            bits &= bits - 1;
+        return 8 * byte + __builtin_ctzll(bits);
+#endif
+    }
+
+      // A cell drawn uniformly from a non-empty set
+    int pickCell(const Bitboard& set, RandomStream& rs)
+    {
+        int inLo = countBits(set.lo);
+        int k = rs.below(inLo + countBits(set.hi));
+        return k < inLo ? selectBit(set.lo, k) : 64 + selectBit(set.hi, k - inLo);
+    }
+
+      // The same, for a set that covers much of the board.  The low 7 bits
+      // of each byte of a draw are a uniform cell index below
+      // BITBOARD_CELLS, so the first of them that lands in the set is
+      // uniform over it; that is usually one draw and no counting.
+    int pickFromMost(const Bitboard& set, RandomStream& rs)
+    {
+        uint64_t r = rs.next();
+        for (int k = 0; k < 8; k++, r >>= 8)
+        {
+            int c = int(r & (BITBOARD_CELLS - 1));
+            if (set.test(c))
+                return c;
+        }
+        return pickCell(set, rs);
+    }
+}
+
+bool batchStrategy(const string& type, BatchStrategy& s)
+{
+    if (type == "awful")
+        s = BATCH_AWFUL;
+    else if (type == "mediocre")
+        s = BATCH_MEDIOCRE;
+    else if (type == "good")
+        s = BATCH_GOOD;
+    else
+        return false;
+    return true;
+}
+
+BatchEngine::BatchEngine(const Game& g, BatchStrategy seat0, BatchStrategy seat1, int width)
+ : m_width(max(width, 1)), m_cells(g.rows() * g.cols()), m_cols(g.cols()),
+   m_nShips(g.nShips()), m_generator(g)
+{
+    m_ok = (m_cells <= BITBOARD_CELLS && m_nShips >= 1 && m_nShips <= MAX_SHIPS);
+    if (!m_ok)
+        return;
+    for (int s = 0; s < m_nShips; s++)
+        m_lengths.push_back(g.shipLength(s));
+    for (int c = 0; c < m_cells; c++)
+        m_all.set(c);
+    m_opening = openingLine(g);
+
+      // The cells in line with each cell that the players aim at after a hit
+    int rows = g.rows();
+    m_cross1.resize(m_cells);
+    m_cross4.resize(m_cells);
+    m_row4.resize(m_cells);
+    m_col4.resize(m_cells);
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < m_cols; c++)
+        {
+            int cell = r * m_cols + c;
+            for (int d = 1; d <= 4; d++)
+            {
+                Bitboard row, col;
+                if (c - d >= 0)
+                    row.set(cell - d);
+                if (c + d < m_cols)
+                    row.set(cell + d);
+                if (r - d >= 0)
+                    col.set(cell - d * m_cols);
+                if (r + d < rows)
+                    col.set(cell + d * m_cols);
+                if (d == 1)
+                    m_cross1[cell] = row | col;
+                m_row4[cell] |= row;
+                m_col4[cell] |= col;
+            }
+            m_cross4[cell] = m_row4[cell] | m_col4[cell];
+        }
+    }
+
+    BatchStrategy strategies[2] = { seat0, seat1 };
+    for (int s = 0; s < 2; s++)
+    {
+        Seat& seat = m_seats[s];
+        seat.strategy = strategies[s];
+        seat.shotLo.resize(m_width);
+        seat.shotHi.resize(m_width);
+        seat.shipAt.resize(size_t(m_width) * BITBOARD_CELLS);
+        seat.afloat.resize(size_t(m_width) * m_nShips);
+        seat.alive.resize(m_width);
+        seat.state.resize(m_width);
+        seat.lastHit.resize(m_width);
+        seat.horizontal.resize(m_width);
+        seat.cursor.resize(m_width);
+        seat.opening.resize(m_width);
+        seat.rng.resize(m_width);
+    }
+    m_game.resize(m_width);
+}
+
+void BatchEngine::run(uint64_t seed, long first, long count, long stride, BatchResult& result)
+{
+    if (!m_ok)
+    {
+        result.games += count;
+        result.failed += count;
+        return;
+    }
+    long next = 0;
+    while (next < count)
+    {
+          // Fill a wave, then play it out
+        int n = 0;
+        while (n < m_width && next < count)
+        {
+            long k = first + next * stride;
+            next++;
+            result.games++;
+            if (startGame(n, seed, k))
+                n++;
+            else
+                result.failed++;
+        }
+        for (int step = 0; n > 0; step++)
+        {
+            int a = step % 2;
+            Seat& attacker = m_seats[a];
+            Seat& defender = m_seats[1 - a];
+            bool anyOver;
+            switch (attacker.strategy)
+            {
+              case BATCH_AWFUL:
+                anyOver = playStep<BATCH_AWFUL>(attacker, defender, n);
+                break;
+              case BATCH_MEDIOCRE:
+                anyOver = playStep<BATCH_MEDIOCRE>(attacker, defender, n);
+                break;
+              default:
+                anyOver = playStep<BATCH_GOOD>(attacker, defender, n);
+                break;
+            }
+            if (!anyOver)
+                continue;
+              // Every game in the wave has had the same number of turns
+            for (int i = 0; i < n; )
+            {
+                if (defender.alive[i] != 0)
+                {
+                    i++;
+                    continue;
+                }
+                result.wins[a]++;
+                result.shots[0] += step / 2 + 1;
+                result.shots[1] += (step + 1) / 2;
+                n--;
+                if (i != n)
+                    moveSlot(n, i);
+            }
+        }
+    }
+}
+
+  // Set up both seats of game k in a slot; false if a fleet can't be placed
+bool BatchEngine::startGame(int slot, uint64_t seed, long k)
+{
+    m_game[slot] = k;
+    for (int s = 0; s < 2; s++)
+    {
+        Seat& seat = m_seats[s];
+          // Like Game::simulate, each seat places its ships and then plays
+          // from its own stream
+        RandomStream rs(seed, k, PLAYER1_STREAM + s);
+        if (!placeFleet(seat, slot, rs))
+            return false;
+        seat.rng[slot] = rs;
+        seat.shotLo[slot] = seat.shotHi[slot] = 0;
+        seat.alive[slot] = (m_nShips == 32 ? ~uint32_t(0) : (uint32_t(1) << m_nShips) - 1);
+        seat.state[slot] = 1;
+        seat.lastHit[slot] = 0;
+        seat.horizontal[slot] = 1;
+        seat.cursor[slot] = 0;
+        seat.opening[slot] = 0;
+    }
+    return true;
+}
+
+bool BatchEngine::placeFleet(Seat& seat, int slot, RandomStream& rs)
+{
+    m_layout.resize(m_nShips);
+    if (seat.strategy == BATCH_AWFUL)
+    {
+          // Ship k along the left of row k, as AwfulPlayer does
+        if (m_nShips > m_cells / m_cols)
+            return false;
+        for (int s = 0; s < m_nShips; s++)
+        {
+            if (m_lengths[s] > m_cols)
+                return false;
+            m_layout[s].topOrLeft = Point(s, 0);
+            m_layout[s].dir = HORIZONTAL;
+        }
+    }
+    else if (!m_generator.generate(rs, m_layout))
+        return false;
+
+    uint8_t* shipAt = &seat.shipAt[size_t(slot) * BITBOARD_CELLS];
+    fill(shipAt, shipAt + BITBOARD_CELLS, NO_SHIP);
+    for (int s = 0; s < m_nShips; s++)
+    {
+        int start = m_layout[s].topOrLeft.r * m_cols + m_layout[s].topOrLeft.c;
+        int step = (m_layout[s].dir == HORIZONTAL ? 1 : m_cols);
+        for (int k = 0; k < m_lengths[s]; k++)
+            shipAt[start + k * step] = uint8_t(s);
+        seat.afloat[size_t(s) * m_width + slot] = uint8_t(m_lengths[s]);
+    }
+    return true;
+}
+
+  // One step of every game in play: the attacker picks its shot as its
+  // player's recommendAttack would, the shot lands on the defender's board,
+  // and the attacker learns the result as recordAttackResult would.  The
+  // strategy is a template argument, so the loop body has no dispatch.
+  // Returns whether any defender lost its last ship.
+template <int Strategy>
+bool BatchEngine::playStep(Seat& a, Seat& d, int n)
+{
+    bool anyOver = false;
+    for (int i = 0; i < n; i++)
+    {
+        int c = -1;
+        int state = 1;
+        if (Strategy == BATCH_AWFUL)
+        {
+              // Walk the board backwards from the last cell
+            c = a.cursor[i] - 1;
+            if (c < 0)
+                c = m_cells - 1;
+            a.cursor[i] = c;
+        }
+        else
+        {
+              // After a hit, the mediocre player fires within 4 cells of it
+              // in line until a ship sinks; the good player probes the hit's
+              // neighbours, then follows the line of the second hit
+            Bitboard untried = m_all.andNot(Bitboard(d.shotLo[i], d.shotHi[i]));
+            state = a.state[i];
+            if (state >= 2)
+            {
+                int hit = a.lastHit[i];
+                Bitboard near = untried;
+                if (Strategy == BATCH_MEDIOCRE)
+                    near &= m_cross4[hit];
+                else
+                    near &= (state == 2 ? m_cross1[hit] : state == 3 ? m_row4[hit] : m_col4[hit]);
+                if (near.any())
+                {
+                    c = pickCell(near, a.rng[i]);
+                    if (Strategy == BATCH_GOOD && state == 2)
+                        a.horizontal[i] = (c / m_cols == hit / m_cols);
+                }
+                else
+                    state = 1;
+            }
+              // Until the first hit, follow the opening line, skipping any
+              // cell already tried, as the scalar players do
+            while (c < 0 && a.opening[i] < int(m_opening.size()))
+            {
+                c = m_opening[a.opening[i]++];
+                if (!untried.test(c))
+                    c = -1;
+            }
+            if (c < 0)
+                c = pickFromMost(untried, a.rng[i]);
+        }
+
+        uint64_t bit = uint64_t(1) << (c & 63);
+        d.shotLo[i] |= (c < 64 ? bit : 0);
+        d.shotHi[i] |= (c < 64 ? 0 : bit);
+        uint8_t ship = d.shipAt[size_t(i) * BITBOARD_CELLS + c];
+        if (ship != NO_SHIP)
+        {
+            if (Strategy != BATCH_AWFUL)
+                a.opening[i] = int(m_opening.size());
+            bool destroyed = (--d.afloat[size_t(ship) * m_width + i] == 0);
+            if (destroyed)
+            {
+                d.alive[i] &= ~(uint32_t(1) << ship);
+                anyOver |= (d.alive[i] == 0);
+                state = 1;
+            }
+            else if (state == 1)
+            {
+                state = 2;
+                a.lastHit[i] = uint8_t(c);
+            }
+            else if (Strategy == BATCH_GOOD && state == 2)
+                state = (a.horizontal[i] ? 3 : 4);
+        }
+        if (Strategy != BATCH_AWFUL)
+            a.state[i] = uint8_t(state);
+    }
+    return anyOver;
+}
+
+void BatchEngine::moveSlot(int from, int to)
+{
+    m_game[to] = m_game[from];
+    for (Seat& seat : m_seats)
+    {
+        seat.shotLo[to] = seat.shotLo[from];
+        seat.shotHi[to] = seat.shotHi[from];
+        copy_n(&seat.shipAt[size_t(from) * BITBOARD_CELLS], BITBOARD_CELLS,
+               &seat.shipAt[size_t(to) * BITBOARD_CELLS]);
+        for (int s = 0; s < m_nShips; s++)
+            seat.afloat[size_t(s) * m_width + to] = seat.afloat[size_t(s) * m_width + from];
+        seat.alive[to] = seat.alive[from];
+        seat.state[to] = seat.state[from];
+        seat.lastHit[to] = seat.lastHit[from];
+        seat.horizontal[to] = seat.horizontal[from];
+        seat.cursor[to] = seat.cursor[from];
+        seat.opening[to] = seat.opening[from];
+        seat.rng[to] = seat.rng[from];
+    }
+}
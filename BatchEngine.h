@@ -0,0 +1,107 @@
+#ifndef BATCHENGINE_INCLUDED
+#define BATCHENGINE_INCLUDED
+
+#include "Bitboard.h"
+#include "FleetGenerator.h"
+#include "Random.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class Game;
+
+  // The computer players that have batch versions.  Each plays like its
+  // createPlayer namesake: the same placement rule and the same shot
+  // choices given the same knowledge, though not the same random draws.
+enum BatchStrategy { BATCH_AWFUL, BATCH_MEDIOCRE, BATCH_GOOD };
+
+  // The batch strategy for a createPlayer type; false if there is none
+bool batchStrategy(const std::string& type, BatchStrategy& s);
+
+struct BatchResult
+{
+    long games = 0;
+    long wins[2] = { 0, 0 };     // by seat; seat 0 moves first
+    long shots[2] = { 0, 0 };
+    long failed = 0;             // games in which a fleet could not be placed
+};
+
+  // Plays many games of one configuration (at most BITBOARD_CELLS cells and
+  // MAX_SHIPS ships) between two strategies at once.  Up to width games are
+  // kept in structure-of-arrays form: each field of every game's boards and
+  // players is an array indexed by slot.  All games of a wave start
+  // together, so on every step the same seat moves in each of them.  A
+  // step is one loop over the slots that, for each game in turn, chooses
+  // the shot, applies it and updates the attacker's state (a shot is one
+  // load of the ship at the cell and a decrement of that ship's cells left
+  // afloat, with no per-game objects or virtual calls).  Finished games
+  // are then retired by moving the last active slot into their place, so
+  // the loop only ever covers games still in play.  A game keyed (seed, k)
+  // plays the same way whatever else is in its wave.
+  //
+  // Known limitation: choosing a shot branches on each game's knowledge
+  // and random draws, and it is most of the work, so the loop does not
+  // vectorize.  The engine runs about 2x the games/s of scalar games for
+  // the mediocre and good players and about 7x for the awful one, not an
+  // order of magnitude.  Splitting the step into separate passes, with the
+  // apply, sunk and game-over passes branch-free, played the same games
+  // 10-35% slower, so the loop stays fused.
+class BatchEngine
+{
+  public:
+    static const int MAX_SHIPS = 32;
+    static constexpr uint8_t NO_SHIP = 0xff;
+
+    BatchEngine(const Game& g, BatchStrategy seat0, BatchStrategy seat1, int width = 1024);
+      // Whether the game's configuration fits a batch
+    bool ok() const { return m_ok; }
+      // Play the games keyed (seed, first), (seed, first + stride), ...,
+      // count in all, and add their outcomes to result
+    void run(uint64_t seed, long first, long count, long stride, BatchResult& result);
+    BatchEngine(const BatchEngine&) = delete;
+    BatchEngine& operator=(const BatchEngine&) = delete;
+
+  private:
+      // One seat's board and player, across all slots
+    struct Seat
+    {
+        BatchStrategy strategy;
+        std::vector<uint64_t> shotLo, shotHi;   // cells shot at by the opponent
+        std::vector<uint8_t> shipAt;            // cell c of slot i at i*BITBOARD_CELLS+c:
+                                                // the ship there, or NO_SHIP
+        std::vector<uint8_t> afloat;            // cells of ship j of slot i not yet
+                                                // hit, at j*width+i
+        std::vector<uint32_t> alive;            // ships not yet sunk, one bit each
+        std::vector<uint8_t> state;             // the player's hunt/target state
+        std::vector<uint8_t> lastHit;
+        std::vector<uint8_t> horizontal;        // good: the probe went sideways
+        std::vector<int> cursor;                // awful: the last cell fired at
+        std::vector<int> opening;               // the next shot of the opening line,
+                                                // or its end after the first hit
+        std::vector<RandomStream> rng;
+    };
+
+    bool startGame(int slot, uint64_t seed, long k);
+    bool placeFleet(Seat& s, int slot, RandomStream& rs);
+    template <int Strategy> bool playStep(Seat& attacker, Seat& defender, int n);
+    void moveSlot(int from, int to);
+
+    int m_width;
+    bool m_ok;
+    int m_cells;
+    int m_cols;
+    int m_nShips;
+    Bitboard m_all;
+    std::vector<Bitboard> m_cross1;   // per cell, the cells next to it
+    std::vector<Bitboard> m_cross4;   // up to 4 cells away in each direction
+    std::vector<Bitboard> m_row4;     // up to 4 cells away left or right
+    std::vector<Bitboard> m_col4;     // up to 4 cells away up or down
+    FleetGenerator m_generator;
+    std::vector<ShipPlacement> m_layout;
+    std::vector<int> m_lengths;
+    std::vector<int> m_opening;       // see openingLine
+    Seat m_seats[2];
+    std::vector<long> m_game;         // the game index in each slot
+};
+
+#endif // BATCHENGINE_INCLUDED
@@ -0,0 +1,146 @@
+#include "Benchmark.h"
+#include "Timer.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <cstdlib>
+
+using namespace std;
+
+namespace
+{
+    volatile long resultSink;
+}
+
+void keepResult(long v)
+{
+    resultSink = v;
+}
+
+void BenchmarkSuite::add(const string& name, const string& unit,
+                         function<long()> body, function<void()> setup)
+{
+    Entry e;
+    e.name = name;
+    e.unit = unit;
+    e.body = body;
+    e.setup = setup;
+    m_entries.push_back(e);
+}
+
+vector<BenchmarkResult> BenchmarkSuite::run(const string& filter, double minSeconds,
+                                            ostream& progress) const
+{
+    vector<BenchmarkResult> results;
+    for (const Entry& e : m_entries)
+    {
+        if (e.name.find(filter) == string::npos)
+            continue;
+        BenchmarkResult r;
+        r.name = e.name;
+        r.unit = e.unit;
+          // One untimed round first, so lazily built tables and caches are
+          // warm before anything is measured
+        if (e.setup)
+            e.setup();
+        e.body();
+        while (r.seconds < minSeconds)
+        {
+            if (e.setup)
+                e.setup();
+            Timer t;
+            r.ops += e.body();
+            r.seconds += t.elapsed() / 1000;
+        }
+        r.rate = r.ops / r.seconds;
+        progress << left << setw(40) << r.name << right << setw(14) << setprecision(6)
+                 << r.rate << ' ' << r.unit << "/s" << endl;
+        results.push_back(r);
+    }
+    return results;
+}
+
+bool writeCsv(const vector<BenchmarkResult>& results, const string& path)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out << "name,unit,rate,ops,seconds\n" << setprecision(10);
+    for (const BenchmarkResult& r : results)
+        out << r.name << ',' << r.unit << ',' << r.rate << ',' << r.ops << ',' << r.seconds << '\n';
+    return bool(out);
+}
+
+bool readCsv(const string& path, vector<BenchmarkResult>& results)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    string line;
+    getline(in, line);  // header
+    while (getline(in, line))
+    {
+        if (line.empty())
+            continue;
+        istringstream fields(line);
+        BenchmarkResult r;
+        string rate, ops, seconds;
+        if (!getline(fields, r.name, ',') || !getline(fields, r.unit, ',') ||
+            !getline(fields, rate, ','))
+            return false;
+        getline(fields, ops, ',');
+        getline(fields, seconds, ',');
+        r.rate = atof(rate.c_str());
+        r.ops = atol(ops.c_str());
+        r.seconds = atof(seconds.c_str());
+        results.push_back(r);
+    }
+    return true;
+}
+
+bool writeJson(const vector<BenchmarkResult>& results, const string& path)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+      // Names and units are plain identifiers, so nothing needs escaping
+    out << "[\n" << setprecision(10);
+    for (size_t k = 0; k < results.size(); k++)
+    {
+        const BenchmarkResult& r = results[k];
+        out << "  {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit
+            << "\", \"rate\": " << r.rate << ", \"ops\": " << r.ops
+            << ", \"seconds\": " << r.seconds << "}" << (k + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "]\n";
+    return bool(out);
+}
+
+int compareWithBaseline(const vector<BenchmarkResult>& results,
+                        const vector<BenchmarkResult>& baseline,
+                        double tolerance, ostream& out)
+{
+    map<string, double> base;
+    for (const BenchmarkResult& r : baseline)
+        base[r.name] = r.rate;
+    int regressions = 0;
+    for (const BenchmarkResult& r : results)
+    {
+        out << left << setw(40) << r.name << right;
+        map<string, double>::const_iterator it = base.find(r.name);
+        if (it == base.end() || it->second <= 0)
+        {
+            out << "  no baseline" << endl;
+            continue;
+        }
+        double ratio = r.rate / it->second;
+        bool regressed = ratio < 1 - tolerance;
+        if (regressed)
+            regressions++;
+        out << setw(10) << fixed << setprecision(3) << ratio << defaultfloat
+            << "x baseline" << (regressed ? "  REGRESSION" : "") << endl;
+    }
+    return regressions;
+}
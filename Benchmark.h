@@ -0,0 +1,61 @@
+#ifndef BENCHMARK_INCLUDED
+#define BENCHMARK_INCLUDED
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iosfwd>
+
+  // One measured benchmark: ops operations in seconds of timed work
+struct BenchmarkResult
+{
+    std::string name;
+    std::string unit;       // what one op is, e.g. "games" or "attacks"
+    double rate = 0;        // ops per second
+    long ops = 0;
+    double seconds = 0;
+};
+
+  // A list of named benchmarks.  A benchmark is a body that does one round
+  // of work and returns how many ops it did, plus an optional setup run
+  // before every round outside the timed region.  Rounds repeat until the
+  // timed work adds up to the minimum time.
+class BenchmarkSuite
+{
+  public:
+    void add(const std::string& name, const std::string& unit,
+             std::function<long()> body, std::function<void()> setup = nullptr);
+      // Run every benchmark whose name contains filter, reporting each one
+      // on progress as it finishes
+    std::vector<BenchmarkResult> run(const std::string& filter, double minSeconds,
+                                     std::ostream& progress) const;
+
+  private:
+    struct Entry
+    {
+        std::string name;
+        std::string unit;
+        std::function<long()> body;
+        std::function<void()> setup;
+    };
+    std::vector<Entry> m_entries;
+};
+
+  // Hand a benchmark's result to a store the optimizer must keep, so the
+  // work that produced it can't be optimized away
+void keepResult(long v);
+
+  // CSV has a header line and one "name,unit,rate,ops,seconds" line per
+  // result; any CSV written here can be read back as a baseline
+bool writeCsv(const std::vector<BenchmarkResult>& results, const std::string& path);
+bool readCsv(const std::string& path, std::vector<BenchmarkResult>& results);
+bool writeJson(const std::vector<BenchmarkResult>& results, const std::string& path);
+
+  // Print each result next to its baseline and return how many ran slower
+  // than (1 - tolerance) times the baseline rate.  Results with no baseline
+  // are listed but never count as regressions.
+int compareWithBaseline(const std::vector<BenchmarkResult>& results,
+                        const std::vector<BenchmarkResult>& baseline,
+                        double tolerance, std::ostream& out);
+
+#endif // BENCHMARK_INCLUDED
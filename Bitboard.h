@@ -0,0 +1,78 @@
+#ifndef BITBOARD_INCLUDED
+#define BITBOARD_INCLUDED
+
+#include <cstdint>
+
+  // Number of cells a Bitboard can describe.  Cell (r,c) of a board with
+  // nCols columns is bit r*nCols+c.
+const int BITBOARD_CELLS = 128;
+
+  // A 128-bit set of board cells.  Every operation is a couple of word-wide
+  // instructions, so placement, attack and sunk tests on a board become
+  // mask operations instead of walks over a grid of chars.
+class Bitboard
+{
+  public:
+    constexpr Bitboard() : lo(0), hi(0) {}
+    constexpr Bitboard(uint64_t l, uint64_t h) : lo(l), hi(h) {}
+
+    static constexpr Bitboard cell(int idx)
+    {
+        return idx < 64 ? Bitboard(uint64_t(1) << idx, 0)
+                        : Bitboard(0, uint64_t(1) << (idx - 64));
+    }
+
+      // The cells start, start+stride, ..., start+(len-1)*stride
+    static constexpr Bitboard line(int start, int len, int stride)
+    {
+        Bitboard b;
+        for (int k = 0; k < len; k++)
+            b.set(start + k * stride);
+        return b;
+    }
+
+    constexpr bool test(int idx) const
+    {
+        return idx < 64 ? (lo >> idx) & 1 : (hi >> (idx - 64)) & 1;
+    }
+    constexpr void set(int idx)
+    {
+        if (idx < 64)
+            lo |= uint64_t(1) << idx;
+        else
+            hi |= uint64_t(1) << (idx - 64);
+    }
+    constexpr void reset(int idx)
+    {
+        if (idx < 64)
+            lo &= ~(uint64_t(1) << idx);
+        else
+            hi &= ~(uint64_t(1) << (idx - 64));
+    }
+
+    constexpr bool any() const { return (lo | hi) != 0; }
+    constexpr bool none() const { return (lo | hi) == 0; }
+    int count() const { return __builtin_popcountll(lo) + __builtin_popcountll(hi); }
+
+      // Index of the lowest set cell; the set must not be empty
+    int lowest() const
+    {
+        return lo != 0 ? __builtin_ctzll(lo) : 64 + __builtin_ctzll(hi);
+    }
+
+    constexpr Bitboard operator&(const Bitboard& o) const { return Bitboard(lo & o.lo, hi & o.hi); }
+    constexpr Bitboard operator|(const Bitboard& o) const { return Bitboard(lo | o.lo, hi | o.hi); }
+    constexpr Bitboard operator^(const Bitboard& o) const { return Bitboard(lo ^ o.lo, hi ^ o.hi); }
+    constexpr Bitboard operator~() const { return Bitboard(~lo, ~hi); }
+    constexpr Bitboard andNot(const Bitboard& o) const { return Bitboard(lo & ~o.lo, hi & ~o.hi); }
+    constexpr Bitboard& operator&=(const Bitboard& o) { lo &= o.lo; hi &= o.hi; return *this; }
+    constexpr Bitboard& operator|=(const Bitboard& o) { lo |= o.lo; hi |= o.hi; return *this; }
+    constexpr Bitboard& operator^=(const Bitboard& o) { lo ^= o.lo; hi ^= o.hi; return *this; }
+    constexpr bool operator==(const Bitboard& o) const { return lo == o.lo && hi == o.hi; }
+    constexpr bool operator!=(const Bitboard& o) const { return !(*this == o); }
+
+    uint64_t lo;
+    uint64_t hi;
+};
+
+#endif // BITBOARD_INCLUDED
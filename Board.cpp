@@ -1,25 +1,37 @@
 ﻿#include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "Bitboard.h"
+#include "PlacementTable.h"
+#include "Instrument.h"
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <map>
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std;
 
-class BoardImpl
+#ifdef BOARD_DIFFERENTIAL
+
+  // The original char-grid board, kept only to cross-check the bitboard
+  // representation.  Compile with -DBOARD_DIFFERENTIAL to run every board
+  // operation against both and abort on the first disagreement.
+class LegacyBoard
 {
   public:
-    BoardImpl(const Game& g);
+    LegacyBoard(const Game& g);
     void clear();
-    void block();
+    void copyBlocked(const Bitboard& blocked);
     void unblock();
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
-    void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
+    char at(int r, int c) const { return board[r][c]; }
 
   private:
     struct ship
@@ -31,101 +43,53 @@ class BoardImpl
     };
     const Game& m_game;
     vector<vector<char>> board;
-    vector<int> Id;
     vector<ship> placedShips;
 };
 
-BoardImpl::BoardImpl(const Game& g)
-    : m_game(g)
-{
-    board.resize(g.rows());
-    for (int i = 0; i < g.rows(); i++)
-    {
-        board[i].resize(g.cols());
-        for (int j = 0; j < g.cols(); j++)
-        {
-            board[i][j] = '.';
-        }
-    }
+LegacyBoard::LegacyBoard(const Game& g)
+    : m_game(g), board(g.rows(), vector<char>(g.cols(), '.'))
+{}
 
-}
-
-void BoardImpl::clear()
+void LegacyBoard::clear()
 {
     for (int i = 0; i < m_game.rows(); i++)
-    {
         for (int j = 0; j < m_game.cols(); j++)
-        {
             board[i][j] = '.';
-        }
-    }
+    placedShips.clear();
 }
 
-void BoardImpl::block()
+  // block() draws random cells, so the legacy grid takes the bitboard's choice
+void LegacyBoard::copyBlocked(const Bitboard& blocked)
 {
-    int R = m_game.rows();
-    int C = m_game.cols();
-    int amount = R * C / 2;
-    for (int i = 0; i < amount; i++) 
-    {
-        int randomR = randInt(R);
-        int randomC = randInt(C);
-        if (board[randomR][randomC] == '.') 
-        {
-            board[randomR][randomC] = '#';
-        }
-        else 
-        {
-            i--;
-        }
-    }
+    for (int i = 0; i < m_game.rows(); i++)
+        for (int j = 0; j < m_game.cols(); j++)
+            if (blocked.test(i * m_game.cols() + j))
+                board[i][j] = '#';
 }
 
-void BoardImpl::unblock()
+void LegacyBoard::unblock()
 {
-    int R = m_game.rows();
-    int C = m_game.cols();
-    for (int i = 0; i < R; i++)
-    {
-        for (int j = 0; j < C; j++)
-        {
+    for (int i = 0; i < m_game.rows(); i++)
+        for (int j = 0; j < m_game.cols(); j++)
             if (board[i][j] == '#')
-            { board[i][j] = '.'; }
-        }
-    }
+                board[i][j] = '.';
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+bool LegacyBoard::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
     if (shipId < 0 || shipId > m_game.nShips() - 1) { return false; }
     if (topOrLeft.r < 0 || topOrLeft.r > m_game.rows() - 1 || topOrLeft.c < 0 || topOrLeft.c > m_game.cols() - 1) { return false; }
-    if (find(Id.begin(), Id.end(), shipId) != Id.end()) { return false; }
+    for (size_t i = 0; i < placedShips.size(); i++)
+        if (placedShips[i].shipId == shipId) { return false; }
     int length = m_game.shipLength(shipId);
     char sym = m_game.shipSymbol(shipId);
-    if (dir == 0) // horizontal
-    {
-        if ((topOrLeft.c + length) > m_game.cols()) { return false; }
-        for (int i = topOrLeft.c; i < length + topOrLeft.c; i++)
-        {
-            if (board[topOrLeft.r][i] != '.') { return false; }
-        }
-        for (int j = topOrLeft.c; j < length + topOrLeft.c; j++)
-        {
-            board[topOrLeft.r][j] = sym;
-        }
-    }
-    if (dir == 1) // vertical
-    {
-        if ((topOrLeft.r + length) > m_game.rows()) { return false; }
-        for (int i = topOrLeft.r; i < length + topOrLeft.r; i++)
-        {
-            if (board[i][topOrLeft.c] != '.') { return false; }
-        }
-        for (int j = topOrLeft.r; j < length + topOrLeft.r; j++)
-        {
-            board[j][topOrLeft.c] = sym;
-        }
-    }
+    int dr = (dir == VERTICAL ? 1 : 0);
+    int dc = 1 - dr;
+    if (topOrLeft.r + dr * length > m_game.rows() || topOrLeft.c + dc * length > m_game.cols()) { return false; }
+    for (int k = 0; k < length; k++)
+        if (board[topOrLeft.r + dr * k][topOrLeft.c + dc * k] != '.') { return false; }
+    for (int k = 0; k < length; k++)
+        board[topOrLeft.r + dr * k][topOrLeft.c + dc * k] = sym;
     ship s;
     s.mLength = length;
     s.mSymbol = sym;
@@ -134,165 +98,578 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
     return true;
 }
 
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool LegacyBoard::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 {
+    if (shipId < 0 || shipId > m_game.nShips() - 1) { return false; }
+    if (topOrLeft.r < 0 || topOrLeft.r > m_game.rows() - 1 || topOrLeft.c < 0 || topOrLeft.c > m_game.cols() - 1) { return false; }
     int length = m_game.shipLength(shipId);
-    if (shipId > m_game.nShips()) { return false; }
-    if (dir == HORIZONTAL) 
+    char sym = m_game.shipSymbol(shipId);
+    int dr = (dir == VERTICAL ? 1 : 0);
+    int dc = 1 - dr;
+    if (topOrLeft.r + dr * length > m_game.rows() || topOrLeft.c + dc * length > m_game.cols()) { return false; }
+    for (int k = 0; k < length; k++)
+        if (board[topOrLeft.r + dr * k][topOrLeft.c + dc * k] != sym) { return false; }
+    for (int k = 0; k < length; k++)
+        board[topOrLeft.r + dr * k][topOrLeft.c + dc * k] = '.';
+    for (size_t i = 0; i < placedShips.size(); i++)
     {
-        for (int i = topOrLeft.c; i < m_game.shipLength(shipId) + topOrLeft.c; i++)
-        {
-            if (board[topOrLeft.r][i] == '.') { return false; }
-        }
-        for (int j = topOrLeft.c; j < m_game.shipLength(shipId) + topOrLeft.c; j++)
+        if (placedShips[i].shipId == shipId)
         {
-            board[topOrLeft.r][j] = '.';
+            placedShips.erase(placedShips.begin() + i);
+            break;
         }
     }
-    if (dir == VERTICAL) 
+    return true;
+}
+
+bool LegacyBoard::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+    shotHit = false;
+    shipDestroyed = false;
+    if (p.r < 0 || p.r >= m_game.rows() || p.c < 0 || p.c >= m_game.cols())
+        return false;
+    char& cell = board[p.r][p.c];
+    if (cell == 'o' || cell == 'X')
+        return false;
+    if (cell == '.' || cell == '#')
+    {
+        cell = 'o';
+        return true;
+    }
+    for (size_t i = 0; i < placedShips.size(); i++)
     {
-        for (int i = topOrLeft.r; i < m_game.shipLength(shipId) + topOrLeft.r; i++)
+        if (placedShips[i].mSymbol == cell)
         {
-            if (board[i][topOrLeft.c] == '.') { return false; }
+            shipId = placedShips[i].shipId;
+            placedShips[i].hits++;
+            if (placedShips[i].hits == placedShips[i].mLength)
+                shipDestroyed = true;
+            break;
         }
-        for (int j = topOrLeft.r; j < m_game.shipLength(shipId) + topOrLeft.r; j++)
+    }
+    cell = 'X';
+    shotHit = true;
+    return true;
+}
+
+bool LegacyBoard::allShipsDestroyed() const
+{
+    for (int i = 0; i < m_game.rows(); i++)
+        for (int j = 0; j < m_game.cols(); j++)
+            if (board[i][j] != '.' && board[i][j] != 'o' && board[i][j] != 'X' && board[i][j] != '#')
+                return false;
+    return true;
+}
+
+#endif // BOARD_DIFFERENTIAL
+
+  // The operations every board representation provides.  Board picks the
+  // bitboard representation when the board fits in a Bitboard and the sparse
+  // one otherwise.
+class BoardImpl
+{
+  public:
+    virtual ~BoardImpl() {}
+    virtual void clear() = 0;
+    virtual void block() = 0;
+    virtual void unblock() = 0;
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) = 0;
+    virtual bool allShipsDestroyed() const = 0;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const = 0;
+      // The character the unobscured display shows for a cell
+    virtual char cellChar(int r, int c) const = 0;
+    void display(bool shotsOnly) const;
+    void render(bool shotsOnly, string& out) const;
+    void setRandomStream(const RandomStream& rs) { m_rng = rs; }
+
+  protected:
+    BoardImpl(const Game& g);
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    RandomStream m_rng;   // drawn from by block()
+};
+
+BoardImpl::BoardImpl(const Game& g)
+    : m_game(g), m_rows(g.rows()), m_cols(g.cols()),
+      m_rng(g.randomStream(BOARD1_STREAM))
+{}
+
+  // Print the board, as one write
+void BoardImpl::display(bool shotsOnly) const
+{
+    string frame;
+    render(shotsOnly, frame);
+    cout.write(frame.data(), frame.size());
+    cout.flush();
+}
+
+  // Append the board's text to out.  Boards of up to 10 rows and columns
+  // get one digit of row and column number; larger boards right-align the
+  // row numbers and print the column numbers vertically, one header line
+  // per digit.
+void BoardImpl::render(bool shotsOnly, string& out) const
+{
+    int rowWidth = 1;
+    for (int n = m_rows - 1; n >= 10; n /= 10)
+        rowWidth++;
+    int colDigits = 1;
+    for (int n = m_cols - 1; n >= 10; n /= 10)
+        colDigits++;
+    out.reserve(out.size() + size_t(m_rows + colDigits) * (rowWidth + m_cols + 2));
+    for (int d = colDigits - 1; d >= 0; d--)
+    {
+        out.append(rowWidth + 1, ' ');
+        for (int i = 0; i < m_cols; i++)
         {
-            board[j][topOrLeft.c] = '.';
+            int scaled = i;
+            for (int k = 0; k < d; k++)
+                scaled /= 10;
+            out += (scaled > 0 || d == 0 ? char('0' + scaled % 10) : ' ');
         }
+        out += '\n';
     }
-    for (int i = 0; i < placedShips.size(); i++) 
+    for (int k = 0; k < m_rows; k++)
     {
-        if (placedShips.at(i).mSymbol == m_game.shipSymbol(shipId))
+        string label = to_string(k);
+        out.append(rowWidth - label.size(), ' ');
+        out += label;
+        out += ' ';
+        for (int j = 0; j < m_cols; j++)
         {
-            placedShips.erase(placedShips.begin() + i);
+            char ch = cellChar(k, j);
+            if (shotsOnly && ch != 'X' && ch != 'o' && ch != '#')
+                ch = '.';
+            out += ch;
         }
+        out += '\n';
     }
-    return true;
 }
 
-bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+//******************** BitBoardImpl ***********************************
+
+  // Boards of at most BITBOARD_CELLS cells keep every cell set as a mask
+class BitBoardImpl : public BoardImpl
 {
-    if (p.r < 0 || p.r > m_game.rows() || p.c < 0 || p.c > m_game.rows())
+  public:
+    BitBoardImpl(const Game& g);
+    void clear();
+    void block();
+    void unblock();
+    bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    bool allShipsDestroyed() const;
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    char cellChar(int r, int c) const;
+
+  private:
+    bool shipMask(Point topOrLeft, int shipId, Direction dir, Bitboard& mask) const;
+    Bitboard m_occupied;  // cells covered by some ship
+    Bitboard m_shots;     // cells attacked so far
+    Bitboard m_hits;      // attacked cells that held a ship segment
+    Bitboard m_blocked;   // cells reserved by block()
+    vector<Bitboard> m_shipMask;  // indexed by shipId; empty if not placed
+    mutable vector<const PlacementTable*> m_tables;  // indexed by shipId
+    vector<int> m_shipRemaining;  // unhit segments of each placed ship
+    int m_cellShip[BITBOARD_CELLS];  // shipId covering each cell, or -1
+    int m_segmentsLeft;   // unhit segments over the whole fleet
+#ifdef BOARD_DIFFERENTIAL
+    void checkAgainstLegacy(const char* op) const;
+    LegacyBoard m_legacy;
+#endif
+};
+
+BitBoardImpl::BitBoardImpl(const Game& g)
+    : BoardImpl(g), m_shipMask(g.nShips()),
+      m_shipRemaining(g.nShips(), 0), m_segmentsLeft(0)
+#ifdef BOARD_DIFFERENTIAL
+      , m_legacy(g)
+#endif
+{
+    fill(m_cellShip, m_cellShip + BITBOARD_CELLS, -1);
+}
+
+void BitBoardImpl::clear()
+{
+    m_occupied = m_shots = m_hits = m_blocked = Bitboard();
+    m_shipMask.assign(m_game.nShips(), Bitboard());
+    m_shipRemaining.assign(m_game.nShips(), 0);
+    fill(m_cellShip, m_cellShip + BITBOARD_CELLS, -1);
+    m_segmentsLeft = 0;
+#ifdef BOARD_DIFFERENTIAL
+    m_legacy.clear();
+    checkAgainstLegacy("clear");
+#endif
+}
+
+void BitBoardImpl::block()
+{
+    int nCells = m_rows * m_cols;
+    int amount = nCells / 2;
+      // Block a uniformly random subset of the free cells with a partial
+      // Fisher-Yates shuffle, so the time doesn't depend on collisions
+    int freeCells[BITBOARD_CELLS];
+    int nFree = 0;
+    Bitboard taken = m_occupied | m_blocked;
+    for (int idx = 0; idx < nCells; idx++)
+        if (!taken.test(idx))
+            freeCells[nFree++] = idx;
+    for (int i = 0; i < amount && i < nFree; i++)
     {
-        shotHit = false;
-        shipDestroyed = false;
-        return false;
+        int k = i + m_rng.below(nFree - i);
+        swap(freeCells[i], freeCells[k]);
+        m_blocked.set(freeCells[i]);
     }
+#ifdef BOARD_DIFFERENTIAL
+    m_legacy.copyBlocked(m_blocked);
+    checkAgainstLegacy("block");
+#endif
+}
 
-    if (board[p.r][p.c] == 'o' || board[p.r][p.c] == 'X')
+void BitBoardImpl::unblock()
+{
+    m_blocked = Bitboard();
+#ifdef BOARD_DIFFERENTIAL
+    m_legacy.unblock();
+    checkAgainstLegacy("unblock");
+#endif
+}
+
+  // Compute the cells a ship would cover, or return false if the ship id or
+  // position is out of range
+bool BitBoardImpl::shipMask(Point topOrLeft, int shipId, Direction dir, Bitboard& mask) const
+{
+    if (shipId < 0 || shipId >= m_game.nShips()) { return false; }
+    if (m_tables.size() <= static_cast<size_t>(shipId))
     {
-        shotHit = false;
-        shipDestroyed = false;
-        return false;
+        for (int s = m_tables.size(); s < m_game.nShips(); s++)
+            m_tables.push_back(&placementTable(m_rows, m_cols, m_game.shipLength(s)));
     }
-    else if (board[p.r][p.c] == '.')
+    int i = m_tables[shipId]->index(topOrLeft, dir);
+    if (i < 0) { return false; }
+    mask = m_tables[shipId]->mask(i);
+    return true;
+}
+
+bool BitBoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+{
+    if (m_shipMask.size() < static_cast<size_t>(m_game.nShips()))
     {
-        shotHit = false;    
-        shipDestroyed = false;
-        board[p.r][p.c] = 'o';
-        return true;
+        m_shipMask.resize(m_game.nShips());
+        m_shipRemaining.resize(m_game.nShips(), 0);
     }
-    else
+    Bitboard mask;
+    bool result = shipMask(topOrLeft, shipId, dir, mask) &&
+                  m_shipMask[shipId].none() &&
+                  (mask & (m_occupied | m_blocked)).none();
+    if (result)
     {
-        for (int i = 0; i < placedShips.size(); i++)
+        m_occupied |= mask;
+        m_shipMask[shipId] = mask;
+        for (Bitboard b = mask; b.any(); b.reset(b.lowest()))
+            m_cellShip[b.lowest()] = shipId;
+        int length = m_game.shipLength(shipId);
+        m_shipRemaining[shipId] = length;
+        m_segmentsLeft += length;
+    }
+#ifdef BOARD_DIFFERENTIAL
+    bool legacy = m_legacy.placeShip(topOrLeft, shipId, dir);
+    assert(legacy == result);
+    checkAgainstLegacy("placeShip");
+#endif
+    return result;
+}
+
+bool BitBoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    Bitboard mask;
+    bool result = shipMask(topOrLeft, shipId, dir, mask) &&
+                  static_cast<size_t>(shipId) < m_shipMask.size() &&
+                  m_shipMask[shipId] == mask && (mask & m_hits).none();
+    if (result)
+    {
+        m_occupied = m_occupied.andNot(mask);
+        m_shipMask[shipId] = Bitboard();
+        for (Bitboard b = mask; b.any(); b.reset(b.lowest()))
+            m_cellShip[b.lowest()] = -1;
+        m_segmentsLeft -= m_shipRemaining[shipId];
+        m_shipRemaining[shipId] = 0;
+    }
+#ifdef BOARD_DIFFERENTIAL
+    bool legacy = m_legacy.unplaceShip(topOrLeft, shipId, dir);
+    assert(legacy == result);
+    checkAgainstLegacy("unplaceShip");
+#endif
+    return result;
+}
+
+bool BitBoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+    shotHit = false;
+    shipDestroyed = false;
+    bool result = false;
+    if (p.r >= 0 && p.r < m_rows && p.c >= 0 && p.c < m_cols)
+    {
+        int idx = p.r * m_cols + p.c;
+        if (!m_shots.test(idx))
         {
-            if (placedShips.at(i).mSymbol == board[p.r][p.c])
+            result = true;
+            m_shots.set(idx);
+            int id = m_cellShip[idx];
+            if (id >= 0)
             {
-                shipId = placedShips.at(i).shipId;
-                placedShips[i].hits++;
-                if (placedShips[i].hits == placedShips[i].mLength)
-                {
-                    shipDestroyed = true;
-                }
-                continue;
+                m_hits.set(idx);
+                shotHit = true;
+                shipId = id;
+                m_segmentsLeft--;
+                shipDestroyed = (--m_shipRemaining[id] == 0);
             }
         }
-        board[p.r][p.c] = 'X';
-        shotHit = true;
-        return true;
     }
+#ifdef BOARD_DIFFERENTIAL
+    bool legacyHit = false;
+    bool legacyDestroyed = false;
+    int legacyId = shipId;
+    bool legacy = m_legacy.attack(p, legacyHit, legacyDestroyed, legacyId);
+    assert(legacy == result && legacyHit == shotHit &&
+           legacyDestroyed == shipDestroyed && legacyId == shipId);
+    checkAgainstLegacy("attack");
+#endif
+    return result;
+}
+
+char BitBoardImpl::cellChar(int r, int c) const
+{
+    int idx = r * m_cols + c;
+    if (m_hits.test(idx)) { return 'X'; }
+    if (m_shots.test(idx)) { return 'o'; }
+    if (m_blocked.test(idx)) { return '#'; }
+    if (m_cellShip[idx] >= 0) { return m_game.shipSymbol(m_cellShip[idx]); }
+    return '.';
+}
+
+bool BitBoardImpl::allShipsDestroyed() const
+{
+    return m_segmentsLeft == 0;
+}
+
+bool BitBoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (shipId < 0 || shipId >= int(m_shipMask.size()) || m_shipMask[shipId].none())
+        return false;
+    Bitboard mask = m_shipMask[shipId];
+    int first = mask.lowest();
+    topOrLeft = Point(first / m_cols, first % m_cols);
+    mask.reset(first);
+      // A second cell one column along means horizontal, except on a
+      // one-column board where it is the next row
+    dir = (mask.any() && mask.lowest() - first == m_cols ? VERTICAL : HORIZONTAL);
     return true;
 }
 
-void BoardImpl::display(bool shotsOnly) const
+#ifdef BOARD_DIFFERENTIAL
+void BitBoardImpl::checkAgainstLegacy(const char* op) const
 {
-    string spaces = "  ";
-    cout << spaces;
-    for (int i = 0; i < m_game.cols(); i++) { cout << i; }
-    cout << endl;
-    int k = 0;
-    while (k < m_game.rows()) 
+    for (int r = 0; r < m_rows; r++)
     {
-        cout << k << " ";
-        for (int j = 0; j < m_game.cols(); j++) 
+        for (int c = 0; c < m_cols; c++)
         {
-            if (shotsOnly) 
+            if (cellChar(r, c) != m_legacy.at(r, c))
             {
-                switch (board[k][j])
-                {
-                case '.':
-                case 'X':
-                case 'o':
-                    cout << board[k][j];
-                    break;
-                case '#':
-                    cout << '#';
-                    break;
-                default:
-                    cout << '.';
-                    break;
-                }
-            }
-            if (!shotsOnly) 
-            {
-                switch (board[k][j])
-                {
-                case '.':
-                case 'X':
-                case 'o':
-                    cout << board[k][j];
-                    break;
-                case '#':
-                    cout << '#';
-                    break;
-                default:
-                    if (isalpha(board[k][j])) { cout << board[k][j]; }
-                    else {
-                        cout << '.';
-                    }
-                    break;
-                }
+                cerr << "Board differential mismatch after " << op << " at ("
+                     << r << "," << c << "): bitboard has '" << cellChar(r, c)
+                     << "', char grid has '" << m_legacy.at(r, c) << "'" << endl;
+                abort();
             }
         }
-        k++;
-        cout << endl;
     }
+    assert(allShipsDestroyed() == m_legacy.allShipsDestroyed());
+    assert(m_segmentsLeft == m_occupied.andNot(m_hits).count());
 }
+#endif
 
+//******************** SparseBoardImpl ********************************
 
-bool BoardImpl::allShipsDestroyed() const
+  // Boards too big for a Bitboard keep only what is on them in hash tables:
+  // the cells under ships, the cells shot at and the cells blocked.  Memory
+  // grows with the fleet and the shots, not with the size of the board.
+class SparseBoardImpl : public BoardImpl
 {
-    for (int i = 0; i < m_game.rows(); i++) 
+  public:
+    SparseBoardImpl(const Game& g);
+    void clear();
+    void block();
+    void unblock();
+    bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    bool allShipsDestroyed() const;
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    char cellChar(int r, int c) const;
+
+  private:
+    struct ShipState
     {
-        for (int j = 0; j < m_game.cols(); j++)
-        {
-            if (board[i][j] != 'o' && board[i][j] != 'X' && isalpha(board[i][j]) )
-            {
-                return false;
-            }
-        }
+        bool placed = false;
+        int start = 0;
+        int step = 1;
+        int remaining = 0;     // unhit segments
+    };
+    bool shipCells(Point topOrLeft, int shipId, Direction dir, int& start, int& step) const;
+    unordered_map<int, int> m_cellShip;   // shipId covering each occupied cell
+    unordered_set<int> m_shots;
+    unordered_set<int> m_blocked;
+    vector<ShipState> m_ships;            // indexed by shipId
+    int m_segmentsLeft;
+};
+
+SparseBoardImpl::SparseBoardImpl(const Game& g)
+    : BoardImpl(g), m_ships(g.nShips()), m_segmentsLeft(0)
+{}
+
+void SparseBoardImpl::clear()
+{
+    m_cellShip.clear();
+    m_shots.clear();
+    m_blocked.clear();
+    m_ships.assign(m_game.nShips(), ShipState());
+    m_segmentsLeft = 0;
+}
+
+void SparseBoardImpl::block()
+{
+      // At most half the board is ever taken, so each draw succeeds with
+      // probability at least one half
+    long nCells = long(m_rows) * m_cols;
+    long amount = nCells / 2;
+    long nFree = nCells - long(m_cellShip.size()) - long(m_blocked.size());
+    for (long i = 0; i < amount && i < nFree; )
+    {
+        int r = m_rng.below(m_rows);
+        int idx = r * m_cols + m_rng.below(m_cols);
+        if (m_cellShip.count(idx) == 0 && m_blocked.insert(idx).second)
+            i++;
+    }
+}
+
+void SparseBoardImpl::unblock()
+{
+    m_blocked.clear();
+}
+
+bool SparseBoardImpl::shipCells(Point topOrLeft, int shipId, Direction dir, int& start, int& step) const
+{
+    if (shipId < 0 || shipId >= m_game.nShips()) { return false; }
+    int length = m_game.shipLength(shipId);
+    int i = placementIndex(m_rows, m_cols, length, topOrLeft.r, topOrLeft.c, dir);
+    if (i < 0) { return false; }
+    start = placementStart(m_rows, m_cols, length, i);
+    step = placementStep(m_rows, m_cols, length, i);
+    return true;
+}
+
+bool SparseBoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+{
+    if (m_ships.size() < static_cast<size_t>(m_game.nShips()))
+        m_ships.resize(m_game.nShips());
+    int start, step;
+    if (!shipCells(topOrLeft, shipId, dir, start, step) || m_ships[shipId].placed)
+        return false;
+    int length = m_game.shipLength(shipId);
+    for (int k = 0; k < length; k++)
+    {
+        int cell = start + k * step;
+        if (m_cellShip.count(cell) || m_blocked.count(cell))
+            return false;
+    }
+    for (int k = 0; k < length; k++)
+        m_cellShip[start + k * step] = shipId;
+    ShipState& ship = m_ships[shipId];
+    ship.placed = true;
+    ship.start = start;
+    ship.step = step;
+    ship.remaining = length;
+    m_segmentsLeft += length;
+    return true;
+}
+
+bool SparseBoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    int start, step;
+    if (!shipCells(topOrLeft, shipId, dir, start, step) ||
+        static_cast<size_t>(shipId) >= m_ships.size())
+        return false;
+    ShipState& ship = m_ships[shipId];
+    int length = m_game.shipLength(shipId);
+    if (!ship.placed || ship.start != start || ship.step != step || ship.remaining != length)
+        return false;
+    for (int k = 0; k < length; k++)
+        m_cellShip.erase(start + k * step);
+    ship = ShipState();
+    m_segmentsLeft -= length;
+    return true;
+}
+
+bool SparseBoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+    shotHit = false;
+    shipDestroyed = false;
+    if (p.r < 0 || p.r >= m_rows || p.c < 0 || p.c >= m_cols)
+        return false;
+    int idx = p.r * m_cols + p.c;
+    if (!m_shots.insert(idx).second)
+        return false;
+    unordered_map<int, int>::const_iterator it = m_cellShip.find(idx);
+    if (it != m_cellShip.end())
+    {
+        shotHit = true;
+        shipId = it->second;
+        m_segmentsLeft--;
+        shipDestroyed = (--m_ships[shipId].remaining == 0);
     }
     return true;
 }
 
+bool SparseBoardImpl::allShipsDestroyed() const
+{
+    return m_segmentsLeft == 0;
+}
+
+bool SparseBoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (shipId < 0 || shipId >= int(m_ships.size()) || !m_ships[shipId].placed)
+        return false;
+    const ShipState& ship = m_ships[shipId];
+    topOrLeft = Point(ship.start / m_cols, ship.start % m_cols);
+    dir = (ship.step == m_cols && m_game.shipLength(shipId) > 1 ? VERTICAL : HORIZONTAL);
+    return true;
+}
+
+char SparseBoardImpl::cellChar(int r, int c) const
+{
+    int idx = r * m_cols + c;
+    unordered_map<int, int>::const_iterator it = m_cellShip.find(idx);
+    if (m_shots.count(idx)) { return it != m_cellShip.end() ? 'X' : 'o'; }
+    if (m_blocked.count(idx)) { return '#'; }
+    if (it != m_cellShip.end()) { return m_game.shipSymbol(it->second); }
+    return '.';
+}
+
 //******************** Board functions ********************************
 
 // These functions simply delegate to BoardImpl's functions.
 // You probably don't want to change any of this code.
 
 Board::Board(const Game& g)
+ : m_placeRetries(0)
 {
-    m_impl = new BoardImpl(g);
+    if (g.rows() * g.cols() <= BITBOARD_CELLS)
+        m_impl = new BitBoardImpl(g);
+    else
+        m_impl = new SparseBoardImpl(g);
 }
 
 Board::~Board()
@@ -303,6 +680,7 @@ Board::~Board()
 void Board::clear()
 {
     m_impl->clear();
+    m_placeRetries = 0;
 }
 
 void Board::block()
@@ -317,21 +695,37 @@ void Board::unblock()
 
 bool Board::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
-    return m_impl->placeShip(topOrLeft, shipId, dir);
+    bool placed = m_impl->placeShip(topOrLeft, shipId, dir);
+    if (!placed)
+    {
+        m_placeRetries++;
+        BSIM_COUNT(COUNTER_PLACE_FAILURES, 1);
+    }
+    return placed;
 }
 
 bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 {
-    return m_impl->unplaceShip(topOrLeft, shipId, dir);
+    bool unplaced = m_impl->unplaceShip(topOrLeft, shipId, dir);
+    if (unplaced)
+        m_placeRetries++;
+    return unplaced;
 }
 
 void Board::display(bool shotsOnly) const
 {
+    BSIM_PROBE(PROBE_DISPLAY);
     m_impl->display(shotsOnly);
 }
 
+void Board::render(bool shotsOnly, string& out) const
+{
+    m_impl->render(shotsOnly, out);
+}
+
 bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
+    BSIM_PROBE(PROBE_BOARD_ATTACK);
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
@@ -339,3 +733,23 @@ bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
+int Board::placementRetries() const
+{
+    return m_placeRetries;
+}
+
+void Board::addPlacementRetries(int n)
+{
+    m_placeRetries += n;
+}
+
+void Board::setRandomStream(const RandomStream& rs)
+{
+    m_impl->setRandomStream(rs);
+}
@@ -2,9 +2,11 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <string>
 
 class Game;
 class BoardImpl;
+class RandomStream;
 
 class Board
 {
@@ -17,14 +19,26 @@ class Board
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
+      // Append exactly what display prints
+    void render(bool shotsOnly, std::string& out) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
+      // Where a ship was placed; false if it isn't on the board
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+      // Placements rejected plus ships taken back since the board was
+      // created or last cleared
+    int placementRetries() const;
+      // Count placements tried and abandoned off the board, by a caller
+      // that lays out a fleet before placing it
+    void addPlacementRetries(int n);
+    void setRandomStream(const RandomStream& rs);
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
 
   private:
     BoardImpl* m_impl;
+    int m_placeRetries;
 };
 
 #endif // BOARD_INCLUDED
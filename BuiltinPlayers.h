@@ -0,0 +1,355 @@
+#ifndef BUILTINPLAYERS_INCLUDED
+#define BUILTINPLAYERS_INCLUDED
+
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include "FleetGenerator.h"
+#include "ShotSelector.h"
+#include "OpeningBook.h"
+#include "TranspositionCache.h"
+#include "Tablebase.h"
+#include <string>
+#include <vector>
+#include <variant>
+
+class PlacementTable;
+
+// The computer players that createPlayer builds by name, as concrete final
+// classes.  Through a Player* they behave like any other player; held by
+// value, as in BuiltinPlayer below, calls to them are direct and the small
+// ones inline into the caller's game loop.  Human, Monte Carlo and plugin
+// players stay behind the virtual Player interface only.
+
+//*********************************************************************
+//  AwfulPlayer
+//*********************************************************************
+
+class AwfulPlayer final : public Player
+{
+  public:
+    AwfulPlayer(std::string nm, const Game& g);
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                                bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+  private:
+    Point m_lastCellAttacked;
+};
+
+inline AwfulPlayer::AwfulPlayer(std::string nm, const Game& g)
+ : Player(nm, g), m_lastCellAttacked(0, 0)
+{}
+
+inline bool AwfulPlayer::placeShips(Board& b)
+{
+      // Clustering ships is bad strategy
+    for (int k = 0; k < game().nShips(); k++)
+        if ( ! b.placeShip(Point(k,0), k, HORIZONTAL))
+            return false;
+    return true;
+}
+
+inline Point AwfulPlayer::recommendAttack()
+{
+    if (m_lastCellAttacked.c > 0)
+        m_lastCellAttacked.c--;
+    else
+    {
+        m_lastCellAttacked.c = game().cols() - 1;
+        if (m_lastCellAttacked.r > 0)
+            m_lastCellAttacked.r--;
+        else
+            m_lastCellAttacked.r = game().rows() - 1;
+    }
+    return m_lastCellAttacked;
+}
+
+inline void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
+                                     bool /* shotHit */, bool /* shipDestroyed */,
+                                     int /* shipId */)
+{
+      // AwfulPlayer completely ignores the result of any attack
+}
+
+inline void AwfulPlayer::recordAttackByOpponent(Point /* p */)
+{
+      // AwfulPlayer completely ignores what the opponent does
+}
+
+//*********************************************************************
+//  MediocrePlayer
+//*********************************************************************
+
+class MediocrePlayer final : public Player
+{
+public:
+    MediocrePlayer(std::string nm, const Game& g) : Player(nm, g), mState(1), untried(g.rows(), g.cols()),
+      lines(g.rows(), g.cols()), opening(g)
+    {}
+
+    ~MediocrePlayer() {}
+
+    bool placeShips(Board& b)
+    {
+        FleetGenerator gen(game());
+        return gen.placeFleet(b, rng());
+    }
+
+    Point recommendAttack() 
+    {
+        if (mState == 2) 
+        {
+            int cols = game().cols();
+            int hit = lastPointHit.r * cols + lastPointHit.c;
+            cross.clear();
+            lines.untriedInLine(hit, untried,
+                { LINE_UP, LINE_DOWN, LINE_LEFT, LINE_RIGHT }, 4, cross);
+            if (!cross.empty())
+            {
+                int cell = cross[rng().below(cross.size())];
+                untried.remove(cell);
+                return Point(cell / cols, cell % cols);
+            }
+            mState = 1;
+        }
+          // Until the first hit, follow the opening line
+        for (int cell = opening.next(); cell >= 0; cell = opening.next())
+        {
+            if (untried.contains(cell))
+            {
+                untried.remove(cell);
+                return Point(cell / game().cols(), cell % game().cols());
+            }
+        }
+        return untried.drawPoint(rng());
+    }
+    void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId) 
+    {
+        if (!validShot)
+        {
+            mState = 1;
+            return;
+        }
+        else 
+        {
+            untried.remove(p);
+            if (shotHit) { opening.stop(); }
+            if (mState == 1)
+            {
+                if (!shotHit) { return; }
+                if (shotHit && shipDestroyed) { return; }
+                if (shotHit && !shipDestroyed)
+                {
+                    mState = 2;
+                    lastPointHit = p;
+                    return;
+                }
+            }
+            else if (mState == 2)
+            {
+                if (!shotHit || (shotHit && !shipDestroyed)) { return; }
+                if (shotHit && shipDestroyed) { mState = 1; return; }
+            }
+        }
+    }
+    void recordAttackByOpponent(Point p) {} // this does nothing   
+private:
+    int mState;
+    Point lastPointHit;
+    CellPool untried;
+    LineTable lines;
+    std::vector<int> cross;
+    OpeningCursor opening;
+};
+
+//*********************************************************************
+//  GoodPlayer
+//*********************************************************************
+
+
+class GoodPlayer final : public Player
+{
+public:
+    GoodPlayer(std::string nm, const Game& g) : Player(nm, g), untried(g.rows(), g.cols()),
+      lines(g.rows(), g.cols()), mState(1), dir(HORIZONTAL), opening(g)
+    {}
+    ~GoodPlayer() {}
+    bool placeShips(Board& b) 
+    {
+        FleetGenerator gen(game());
+        return gen.placeFleet(b, rng());
+    }
+
+
+    Point recommendAttack() 
+    {
+        if (mState >= 2 && mState <= 4)
+        {
+            int cols = game().cols();
+            int hit = lastPointHit.r * cols + lastPointHit.c;
+            cross.clear();
+            if (mState == 2)
+                lines.untriedInLine(hit, untried, { LINE_UP, LINE_DOWN, LINE_LEFT, LINE_RIGHT }, 1, cross);
+            else if (mState == 3) // we know it is a horizontal ship (mostly)
+                lines.untriedInLine(hit, untried, { LINE_LEFT, LINE_RIGHT }, 4, cross);
+            else
+                lines.untriedInLine(hit, untried, { LINE_UP, LINE_DOWN }, 4, cross);
+            if (!cross.empty())
+            {
+                int cell = cross[rng().below(cross.size())];
+                untried.remove(cell);
+                if (mState == 2)
+                {
+                    dir = (cell / cols == lastPointHit.r ? HORIZONTAL : VERTICAL);
+                }
+                return Point(cell / cols, cell % cols);
+            }
+            mState = 1;
+        }
+          // Until the first hit, follow the opening line
+        for (int cell = opening.next(); cell >= 0; cell = opening.next())
+        {
+            if (untried.contains(cell))
+            {
+                untried.remove(cell);
+                return Point(cell / game().cols(), cell % game().cols());
+            }
+        }
+        return untried.drawPoint(rng());
+    }
+    void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+    {
+        if (!validShot)
+        {
+            mState = 1;
+            return;
+        }
+        else
+        {
+            untried.remove(p);
+            if (shotHit) { opening.stop(); }
+            if (mState == 1)
+            {
+                if (!shotHit) { return; }
+                if (shotHit && shipDestroyed) { return; }
+                if (shotHit && !shipDestroyed)
+                {
+                    mState = 2;
+                    lastPointHit = p;
+                    return;
+                }
+            }
+            else if (mState == 2)
+            {
+                if ((shotHit && !shipDestroyed) && dir == HORIZONTAL) { mState = 3; return; }
+                else if ((shotHit && !shipDestroyed) && dir == VERTICAL) { mState = 4; return; }
+                if (shotHit && shipDestroyed) { mState = 1; return; }
+            }
+            else if (mState == 3) // we know it is a horizontal ship
+            {
+                if (shotHit && shipDestroyed) { mState = 1; return; }
+            }
+            else if (mState == 4) // we know it is a vertical ship
+            {
+                if (shotHit && shipDestroyed) { mState = 1; return; }
+            }
+        }
+    }
+    void recordAttackByOpponent(Point p) {} // does nothing imo
+private:
+    CellPool untried;
+    LineTable lines;
+    int mState;
+    Point lastPointHit;
+    Direction dir;
+    std::vector<int> cross;
+    OpeningCursor opening;
+};
+
+//*********************************************************************
+//  DensityPlayer
+//*********************************************************************
+
+// For every ship length still afloat, the player tracks each horizontal and
+// vertical placement in the shared PlacementTable.  A placement stays live
+// until it covers a miss or a sunk cell.  Per length it keeps, for every
+// cell, the number of live placements covering it (the hunt heatmap) and
+// the sum of known hits those placements cover (the target heatmap).  A
+// shot only touches the placements through the cell shot, which all lie in
+// its row and column, so recordAttackResult updates a few dozen counters
+// instead of recounting the board.
+//
+// The cells a heatmap ranks best depend only on the knowledge state, so
+// they go into the shared TranspositionCache under the state's hash, and
+// a later game that reaches the same state skips the scan.  A tie is
+// broken by one draw whether or not the cells came from the cache, so a
+// game plays the same however full the cache is.
+
+class DensityPlayer final : public Player
+{
+  public:
+    DensityPlayer(std::string nm, const Game& g);
+    ~DensityPlayer();
+    bool placeShips(Board& b);
+    Point recommendAttack();
+    void recordAttackResult(Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    void recordAttackByOpponent(Point /* p */) {}
+
+  private:
+    enum CellState : char { UNKNOWN, MISS, HIT, SUNK };
+    struct LengthGroup
+    {
+        int length;
+        int alive;                // ships of this length not yet sunk
+        const PlacementTable* table;
+        std::vector<int> blockers;     // misses and sunk cells under each placement
+        std::vector<int> hitsCovered;  // unsunk hits under each placement
+        std::vector<int> live;         // per cell: live placements covering it
+        std::vector<int> hitWeight;    // per cell: hits under those placements
+    };
+    void buildGroup(LengthGroup& grp);
+    void retirePlacement(LengthGroup& grp, int pl);
+    void markMiss(int cell);
+    void markHit(int cell);
+    void markSunk(int cell, int shipId);
+    void retireCell(int cell);
+    void bestCells(bool target, std::vector<int>& best) const;
+
+    int m_rows;
+    int m_cols;
+    std::vector<CellState> m_state;
+    std::vector<LengthGroup> m_groups;
+    int m_unsunkHits;
+    OpeningCursor m_opening;
+      // The knowledge state's Zobrist hash: the configuration, the cells'
+      // states, and the ships of each length afloat
+    uint64_t m_hash;
+    TablebaseProbe m_tablebase;
+    TranspositionCache& m_cache;
+    std::vector<int> m_best;
+    long m_cacheLookups;
+    long m_cacheHits;
+    long m_cacheStores;
+    long m_cacheEvictions;
+};
+
+//*********************************************************************
+//  BuiltinPlayer
+//*********************************************************************
+
+  // One of the players above, held in place.  A std::visit over two of
+  // these instantiates the game loop once per pairing.
+using BuiltinPlayer = std::variant<std::monostate, AwfulPlayer, MediocrePlayer,
+                                   GoodPlayer, DensityPlayer>;
+
+  // Replace p with the player createPlayer(type, nm, g) would build, with
+  // the same fallback from density to good on big boards; false, leaving p
+  // empty, if type has no built-in player
+bool makeBuiltinPlayer(BuiltinPlayer& p, const std::string& type, const std::string& nm,
+                       const Game& g);
+
+#endif // BUILTINPLAYERS_INCLUDED
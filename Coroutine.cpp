@@ -0,0 +1,52 @@
+#include "Coroutine.h"
+
+using namespace std;
+
+namespace
+{
+    thread_local Scheduler* currentScheduler = nullptr;
+}
+
+void Scheduler::schedule(coroutine_handle<> h)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_ready.push_back(h);
+    }
+    m_wake.notify_one();
+}
+
+size_t Scheduler::runReady()
+{
+      // A Task run to completion by syncWait inside a coroutine nests one
+      // scheduler in another, so the outer one is put back afterwards
+    Scheduler* outer = currentScheduler;
+    currentScheduler = this;
+    size_t resumed = 0;
+    for (;;)
+    {
+        coroutine_handle<> h;
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_ready.empty())
+                break;
+            h = m_ready.front();
+            m_ready.pop_front();
+        }
+        h.resume();
+        resumed++;
+    }
+    currentScheduler = outer;
+    return resumed;
+}
+
+void Scheduler::waitForWork()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_wake.wait(lock, [this]() { return !m_ready.empty(); });
+}
+
+Scheduler* Scheduler::current()
+{
+    return currentScheduler;
+}
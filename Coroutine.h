@@ -0,0 +1,208 @@
+#ifndef COROUTINE_INCLUDED
+#define COROUTINE_INCLUDED
+
+#include <coroutine>
+#include <optional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+class Scheduler;
+
+  // A coroutine that produces a T.  It starts suspended and runs when it is
+  // co_awaited, resuming the awaiting coroutine when it returns, or when a
+  // Scheduler it was handed to resumes it.  The Task owns the coroutine's
+  // frame and destroys it along with itself.
+template <class T>
+class Task
+{
+  public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+              // Hand the thread straight to whoever awaited the task
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                std::coroutine_handle<> next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(T v) { value = std::move(v); }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool done() const { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> handle() const { return m_handle; }
+      // The value returned; only once done
+    T& result()
+    {
+        assert(m_handle && m_handle.done());
+        return *m_handle.promise().value;
+    }
+
+    auto operator co_await() noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> h;
+            bool await_ready() noexcept { return h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                h.promise().continuation = awaiting;
+                return h;
+            }
+            T await_resume() { return std::move(*h.promise().value); }
+        };
+        return Awaiter{ m_handle };
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+  private:
+    explicit Task(std::coroutine_handle<promise_type> h) : m_handle(h) {}
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+  // Runs coroutines on the thread that calls runReady.  Any thread may
+  // schedule a coroutine; it is resumed on the next runReady.  A coroutine
+  // suspended on an InputSlot is scheduled again when its input arrives,
+  // so one thread can keep any number of games going, each one advancing
+  // as its input comes in.
+class Scheduler
+{
+  public:
+    void schedule(std::coroutine_handle<> h);
+    template <class T>
+    void start(Task<T>& t) { schedule(t.handle()); }
+      // Resume coroutines until none is ready; returns how many were
+      // resumed
+    size_t runReady();
+      // Block until a coroutine is scheduled
+    void waitForWork();
+      // The scheduler whose runReady is running on this thread, if any
+    static Scheduler* current();
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::coroutine_handle<>> m_ready;
+};
+
+  // A value one coroutine waits for and something outside it supplies,
+  // e.g. a player's move read from a connection.  co_await receive()
+  // yields the value at once if it has been sent, and otherwise suspends
+  // the coroutine until send schedules it on the Scheduler it was running
+  // on.  send may be called from any thread.
+template <class T>
+class InputSlot
+{
+  public:
+    bool waiting() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return bool(m_waiter);
+    }
+
+    void send(T v)
+    {
+        std::coroutine_handle<> waiter;
+        Scheduler* s;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_value = std::move(v);
+            waiter = std::exchange(m_waiter, nullptr);
+            s = m_scheduler;
+        }
+        if (waiter)
+            s->schedule(waiter);
+    }
+
+    auto receive()
+    {
+        struct Awaiter
+        {
+            InputSlot& slot;
+            bool await_ready()
+            {
+                std::lock_guard<std::mutex> lock(slot.m_mutex);
+                return slot.m_value.has_value();
+            }
+            bool await_suspend(std::coroutine_handle<> h)
+            {
+                std::lock_guard<std::mutex> lock(slot.m_mutex);
+                  // A value sent since await_ready means no suspension
+                if (slot.m_value.has_value())
+                    return false;
+                slot.m_scheduler = Scheduler::current();
+                assert(slot.m_scheduler != nullptr);
+                slot.m_waiter = h;
+                return true;
+            }
+            T await_resume()
+            {
+                std::lock_guard<std::mutex> lock(slot.m_mutex);
+                T v = std::move(*slot.m_value);
+                slot.m_value.reset();
+                return v;
+            }
+        };
+        return Awaiter{ *this };
+    }
+
+  private:
+    mutable std::mutex m_mutex;
+    std::optional<T> m_value;
+    std::coroutine_handle<> m_waiter;
+    Scheduler* m_scheduler = nullptr;
+};
+
+  // Run t to completion on a scheduler of its own, blocking this thread
+  // while t waits for input from other threads, and return its value
+template <class T>
+T syncWait(Task<T>& t)
+{
+    Scheduler s;
+    s.start(t);
+    for (;;)
+    {
+        s.runReady();
+        if (t.done())
+            return std::move(t.result());
+        s.waitForWork();
+    }
+}
+
+#endif // COROUTINE_INCLUDED
@@ -0,0 +1,293 @@
+#include "Strategies.h"
+#include "BuiltinPlayers.h"
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include "FleetGenerator.h"
+#include "PlacementTable.h"
+#include <vector>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+      // The chars that stand for each CellState in the hash, as the board
+      // shows them
+    const char STATE_CHARS[] = { '.', 'o', 'X', 'S' };
+
+      // The Zobrist key of ch in cell idx.  The keys come from mix64 rather
+      // than a table, so they are the same in every process and cost
+      // nothing to set up for big boards.  '.' has none, so a state with no
+      // shots hashes to its configuration's key.
+    uint64_t cellKey(int idx, char ch)
+    {
+        if (ch == '.')
+            return 0;
+        return mix64(0x5a6f627269737421ULL ^ (uint64_t(idx) << 8 | uint8_t(ch)));
+    }
+
+      // Zobrist keys for the board size, the fleet, and how many ships of
+      // a length group are afloat
+    uint64_t configKey(const Game& g)
+    {
+        uint64_t key = mix64(0x636f6e666967ULL ^ (uint64_t(g.rows()) << 32 | uint64_t(g.cols())));
+        for (int s = 0; s < g.nShips(); s++)
+            key = mix64(key + uint64_t(g.shipLength(s)));
+        return key;
+    }
+
+    uint64_t aliveKey(size_t group, int alive)
+    {
+        return mix64(0x616c697665ULL ^ (uint64_t(group) << 32 | uint64_t(alive)));
+    }
+}
+
+//*********************************************************************
+//  DensityPlayer
+//*********************************************************************
+
+DensityPlayer::DensityPlayer(string nm, const Game& g)
+ : Player(nm, g), m_rows(g.rows()), m_cols(g.cols()),
+   m_state(g.rows() * g.cols(), UNKNOWN), m_unsunkHits(0), m_opening(g),
+   m_hash(configKey(g)), m_tablebase(g), m_cache(sharedTranspositionCache()), m_cacheLookups(0),
+   m_cacheHits(0), m_cacheStores(0), m_cacheEvictions(0)
+{
+    for (int s = 0; s < g.nShips(); s++)
+    {
+        size_t j = 0;
+        while (j < m_groups.size() && m_groups[j].length != g.shipLength(s))
+            j++;
+        if (j == m_groups.size())
+        {
+            LengthGroup grp;
+            grp.length = g.shipLength(s);
+            grp.alive = 0;
+            grp.table = nullptr;
+            m_groups.push_back(grp);
+        }
+        m_groups[j].alive++;
+    }
+    for (size_t j = 0; j < m_groups.size(); j++)
+        buildGroup(m_groups[j]);
+}
+
+void DensityPlayer::buildGroup(LengthGroup& grp)
+{
+    grp.table = &placementTable(m_rows, m_cols, grp.length);
+    int nCells = m_rows * m_cols;
+    grp.blockers.assign(grp.table->size(), 0);
+    grp.hitsCovered.assign(grp.table->size(), 0);
+    grp.live.resize(nCells);
+    grp.hitWeight.assign(nCells, 0);
+    for (int cell = 0; cell < nCells; cell++)
+        grp.live[cell] = grp.table->coverEnd(cell) - grp.table->coverBegin(cell);
+}
+
+bool DensityPlayer::placeShips(Board& b)
+{
+    FleetGenerator gen(game());
+    return gen.placeFleet(b, rng());
+}
+
+Point DensityPlayer::recommendAttack()
+{
+      // A solved position beats both the opening line and the heatmap
+    int solved = m_tablebase.bestShot();
+    if (solved >= 0 && m_state[solved] == UNKNOWN)
+        return Point(solved / m_cols, solved % m_cols);
+      // Until the first hit, the opening line replaces the heatmap scan
+    for (int cell = m_opening.next(); cell >= 0; cell = m_opening.next())
+        if (m_state[cell] == UNKNOWN)
+            return Point(cell / m_cols, cell % m_cols);
+    int cached[TranspositionCache::MAX_CELLS];
+    m_cacheLookups++;
+    int n = m_cache.lookup(m_hash, cached);
+    if (n > 0)
+    {
+        m_cacheHits++;
+        m_best.assign(cached, cached + n);
+    }
+    else
+    {
+        bestCells(m_unsunkHits > 0, m_best);
+        if (int(m_best.size()) <= TranspositionCache::MAX_CELLS)
+        {
+            m_cacheStores++;
+            if (m_cache.store(m_hash, m_best.data(), m_best.size()))
+                m_cacheEvictions++;
+        }
+    }
+    int cell = m_best[rng().below(m_best.size())];
+    return Point(cell / m_cols, cell % m_cols);
+}
+
+  // The untried cells with the top score, in order
+void DensityPlayer::bestCells(bool target, vector<int>& best) const
+{
+    int nCells = m_rows * m_cols;
+    long bestScore = -1;
+    best.clear();
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        if (m_state[cell] != UNKNOWN)
+            continue;
+        long score = 0;
+        for (size_t j = 0; j < m_groups.size(); j++)
+        {
+            const LengthGroup& grp = m_groups[j];
+            score += long(grp.alive) * (target ? grp.hitWeight[cell] : grp.live[cell]);
+        }
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best.clear();
+        }
+        if (score == bestScore)
+            best.push_back(cell);
+    }
+      // The hits seen can't be explained by any live placement (the
+      // opponent's fleet is unusual); hunt instead
+    if (target && bestScore <= 0)
+        bestCells(false, best);
+}
+
+void DensityPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                       bool shipDestroyed, int shipId)
+{
+    if (!validShot || !game().isValid(p))
+        return;
+    int cell = p.r * m_cols + p.c;
+    if (m_state[cell] != UNKNOWN)
+        return;
+    m_tablebase.record(p, shotHit, shipDestroyed, shipId);
+    if (!shotHit)
+        markMiss(cell);
+    else
+    {
+        m_opening.stop();
+        markHit(cell);
+        if (shipDestroyed)
+            markSunk(cell, shipId);
+    }
+}
+
+  // Remove a placement's contribution from both heatmaps
+void DensityPlayer::retirePlacement(LengthGroup& grp, int pl)
+{
+    int start = grp.table->start(pl);
+    int step = grp.table->step(pl);
+    for (int k = 0; k < grp.length; k++)
+    {
+        int cell = start + k * step;
+        grp.live[cell]--;
+        grp.hitWeight[cell] -= grp.hitsCovered[pl];
+    }
+}
+
+void DensityPlayer::markMiss(int cell)
+{
+    m_state[cell] = MISS;
+    m_hash ^= cellKey(cell, STATE_CHARS[MISS]);
+    for (size_t j = 0; j < m_groups.size(); j++)
+    {
+        LengthGroup& grp = m_groups[j];
+        for (const int* it = grp.table->coverBegin(cell); it != grp.table->coverEnd(cell); ++it)
+        {
+            int pl = *it;
+            if (grp.blockers[pl]++ == 0)
+                retirePlacement(grp, pl);
+        }
+    }
+}
+
+void DensityPlayer::markHit(int cell)
+{
+    m_state[cell] = HIT;
+    m_hash ^= cellKey(cell, STATE_CHARS[HIT]);
+    m_unsunkHits++;
+    for (size_t j = 0; j < m_groups.size(); j++)
+    {
+        LengthGroup& grp = m_groups[j];
+        for (const int* it = grp.table->coverBegin(cell); it != grp.table->coverEnd(cell); ++it)
+        {
+            int pl = *it;
+            grp.hitsCovered[pl]++;
+            if (grp.blockers[pl] == 0)
+            {
+                int start = grp.table->start(pl);
+                int step = grp.table->step(pl);
+                for (int k = 0; k < grp.length; k++)
+                    grp.hitWeight[start + k * step]++;
+            }
+        }
+    }
+}
+
+  // A hit cell that belongs to a sunk ship blocks every placement through it
+  // and no longer counts as evidence for the target heatmap
+void DensityPlayer::retireCell(int cell)
+{
+    m_state[cell] = SUNK;
+    m_hash ^= cellKey(cell, STATE_CHARS[HIT]) ^
+              cellKey(cell, STATE_CHARS[SUNK]);
+    m_unsunkHits--;
+    for (size_t j = 0; j < m_groups.size(); j++)
+    {
+        LengthGroup& grp = m_groups[j];
+        for (const int* it = grp.table->coverBegin(cell); it != grp.table->coverEnd(cell); ++it)
+        {
+            int pl = *it;
+            if (grp.blockers[pl]++ == 0)
+                retirePlacement(grp, pl);
+            grp.hitsCovered[pl]--;
+        }
+    }
+}
+
+void DensityPlayer::markSunk(int cell, int shipId)
+{
+    int len = game().shipLength(shipId);
+    size_t j = 0;
+    while (j < m_groups.size() && m_groups[j].length != len)
+        j++;
+    if (j == m_groups.size())
+        return;
+    LengthGroup& grp = m_groups[j];
+    if (grp.alive > 0)
+    {
+        m_hash ^= aliveKey(j, grp.alive) ^ aliveKey(j, grp.alive - 1);
+        grp.alive--;
+    }
+
+      // The sunk ship lies on some placement of its length through this
+      // cell whose every cell is an unsunk hit; take the first one found
+    int found = -1;
+    for (const int* it = grp.table->coverBegin(cell); it != grp.table->coverEnd(cell) && found < 0; ++it)
+    {
+        if (grp.blockers[*it] == 0 && grp.hitsCovered[*it] == len)
+            found = *it;
+    }
+    if (found < 0)
+    {
+        retireCell(cell);
+        return;
+    }
+    int start = grp.table->start(found);
+    int step = grp.table->step(found);
+    for (int k = 0; k < len; k++)
+        retireCell(start + k * step);
+}
+
+DensityPlayer::~DensityPlayer()
+{
+    m_cache.addCounts(m_cacheLookups, m_cacheHits, m_cacheStores, m_cacheEvictions);
+}
+
+Player* createDensityPlayer(string nm, const Game& g)
+{
+    if (g.rows() * g.cols() > DENSITY_MAX_CELLS)
+        return createPlayer("good", nm, g);
+    return new DensityPlayer(nm, g);
+}
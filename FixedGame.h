@@ -0,0 +1,257 @@
+#ifndef FIXEDGAME_INCLUDED
+#define FIXEDGAME_INCLUDED
+
+#include "globals.h"
+#include "Bitboard.h"
+#include "PlacementTable.h"
+#include "Random.h"
+#include "Game.h"
+#include "FleetGenerator.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+// A compile-time specialized path for the common game configurations.  The
+// board shape and the fleet are template arguments, so every loop over
+// cells, ships or ship segments has a constant trip count and nothing in
+// the turn loop goes through Game's pimpl.  Fleets are drawn by the same
+// FleetGenerator search as runtime-sized games, once per game.  Runtime-
+// sized games keep using Game, Board and Player.
+//
+//     FixedGame<10, 10, 5, 4, 3, 3, 2>    the standard game
+//     FixedGame<2, 3, 2>                  the rowboat mini-game
+
+template <int R, int C, int... Lengths>
+class FixedBoard
+{
+  public:
+    static constexpr int ROWS = R;
+    static constexpr int COLS = C;
+    static constexpr int CELLS = R * C;
+    static constexpr int SHIPS = sizeof...(Lengths);
+    static constexpr int SEGMENTS = (0 + ... + Lengths);
+      // m_placed has a bit per ship, and addShips marks at most MAX_SHIPS
+    static_assert(SHIPS > 0 && SHIPS <= 32 && SHIPS <= MAX_SHIPS, "a fleet needs 1 to 32 ships");
+    static_assert(CELLS <= BITBOARD_CELLS, "the board must fit in a Bitboard");
+
+    static constexpr int shipLength(int shipId)
+    {
+        constexpr int lengths[SHIPS] = { Lengths... };
+        return lengths[shipId];
+    }
+
+    FixedBoard() { clear(); }
+
+    void clear()
+    {
+        m_occupied = m_shots = Bitboard();
+        m_placed = 0;
+        m_segmentsLeft = SEGMENTS;
+        for (int s = 0; s < SHIPS; s++)
+            m_remaining[s] = shipLength(s);
+    }
+
+      // Place a ship, with the same rules as Board::placeShip: on the board,
+      // not overlapping another ship, and not already placed
+    bool placeShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        if (shipId < 0 || shipId >= SHIPS || (m_placed >> shipId & 1))
+            return false;
+        int len = shipLength(shipId);
+        if (placementIndex(R, C, len, topOrLeft.r, topOrLeft.c, dir) < 0)
+            return false;
+        Bitboard mask = Bitboard::line(topOrLeft.r * C + topOrLeft.c, len,
+                                       dir == HORIZONTAL ? 1 : C);
+        if ((m_occupied & mask).any())
+            return false;
+        occupy(mask, shipId);
+        return true;
+    }
+
+      // Place the whole fleet at random with a FleetGenerator, so a fleet
+      // fails to be placed exactly when it would on a Board.  A fleet whose
+      // ships don't all fit on the board is never placed.
+    bool placeRandomFleet(RandomStream& rs)
+    {
+        clear();
+        const Game* g = fleetGame();
+        if (g == nullptr)
+            return false;
+        thread_local FleetGenerator gen(*g);
+        thread_local std::vector<ShipPlacement> layout;
+        if (!gen.generate(rs, layout) || int(layout.size()) != SHIPS)
+            return false;
+        for (int s = 0; s < SHIPS; s++)
+        {
+            if (!placeShip(layout[s].topOrLeft, s, layout[s].dir))
+            {
+                clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+      // Attack a cell, as Board::attack does for a Point
+    bool attack(int cell, bool& shotHit, bool& shipDestroyed, int& shipId)
+    {
+        shotHit = shipDestroyed = false;
+        shipId = -1;
+        if (cell < 0 || cell >= CELLS || m_shots.test(cell))
+            return false;
+        m_shots.set(cell);
+        if (m_occupied.test(cell))
+        {
+            shotHit = true;
+              // A constant number of mask tests, which the compiler unrolls
+            for (int s = 0; s < SHIPS; s++)
+                if (m_shipMask[s].test(cell))
+                    shipId = s;
+            shipDestroyed = (--m_remaining[shipId] == 0);
+            m_segmentsLeft--;
+        }
+        return true;
+    }
+
+    bool allShipsDestroyed() const { return m_segmentsLeft == 0; }
+
+  private:
+      // The configuration as a Game, for FleetGenerator, or nullptr if
+      // Game won't take the fleet; made on first use and kept for the rest
+      // of the program
+    static const Game* fleetGame()
+    {
+        static const Game* g = makeFleetGame();
+        return g;
+    }
+
+    static Game* makeFleetGame()
+    {
+        Game* g = new Game(R, C);
+        if (!addShips(*g, { Lengths... }))
+        {
+            delete g;
+            return nullptr;
+        }
+        return g;
+    }
+
+    void occupy(const Bitboard& mask, int shipId)
+    {
+        m_occupied |= mask;
+        m_shipMask[shipId] = mask;
+        m_placed |= 1u << shipId;
+    }
+
+    Bitboard m_occupied;
+    Bitboard m_shots;
+    unsigned m_placed;            // one bit per ship placed
+    int m_segmentsLeft;
+    int m_remaining[SHIPS];
+    Bitboard m_shipMask[SHIPS];
+};
+
+  // How a fixed game ended
+struct FixedResult
+{
+    int winnerIndex = -1;         // 0 or 1, or -1 if a fleet could not be placed
+    int shots[2] = { 0, 0 };      // shots fired by each side
+};
+
+  // Plays fixed-size games between two players whose types are template
+  // arguments, so their calls inline into the game loop.  A player supplies
+  //
+  //     void newGame(const RandomStream& rs);   // before its first shot
+  //     int recommendAttack();                  // a cell, r * C + c
+  //     void recordAttackResult(int cell, bool validShot, bool shotHit,
+  //                             bool shipDestroyed, int shipId);
+  //
+  // Fleets are placed at random.  Random streams are keyed exactly as
+  // Game::setSeed keys them, so a game replays from (seed, gameIndex).
+template <int R, int C, int... Lengths>
+class FixedGame
+{
+  public:
+    typedef FixedBoard<R, C, Lengths...> BoardType;
+
+    template <class P1, class P2>
+    FixedResult simulate(P1& p1, P2& p2, uint64_t seed, uint64_t gameIndex)
+    {
+        FixedResult result;
+        RandomStream rs1(seed, gameIndex, BOARD1_STREAM);
+        RandomStream rs2(seed, gameIndex, BOARD2_STREAM);
+        if (!m_boards[0].placeRandomFleet(rs1) || !m_boards[1].placeRandomFleet(rs2))
+            return result;
+        p1.newGame(RandomStream(seed, gameIndex, PLAYER1_STREAM));
+        p2.newGame(RandomStream(seed, gameIndex, PLAYER2_STREAM));
+        for (;;)
+        {
+            if (turn(p1, m_boards[1], result.shots[0]))
+            {
+                result.winnerIndex = 0;
+                break;
+            }
+            if (turn(p2, m_boards[0], result.shots[1]))
+            {
+                result.winnerIndex = 1;
+                break;
+            }
+        }
+        return result;
+    }
+
+  private:
+      // One shot; returns true if it sank the target's last ship
+    template <class P>
+    static bool turn(P& attacker, BoardType& target, int& shots)
+    {
+        bool shotHit, shipDestroyed;
+        int shipId;
+        int cell = attacker.recommendAttack();
+        bool valid = target.attack(cell, shotHit, shipDestroyed, shipId);
+        attacker.recordAttackResult(cell, valid, shotHit, shipDestroyed, shipId);
+        shots++;
+        return target.allShipsDestroyed();
+    }
+
+    BoardType m_boards[2];
+};
+
+  // Shoots the untried cells in a uniformly random order, drawing each from
+  // a shrinking array, so no shot is wasted and each costs one draw
+template <int R, int C>
+class FixedRandomPlayer
+{
+  public:
+    void newGame(const RandomStream& rs)
+    {
+        m_rng = rs;
+        m_left = R * C;
+        for (int i = 0; i < R * C; i++)
+            m_cells[i] = i;
+    }
+
+    int recommendAttack()
+    {
+        int k = m_rng.below(m_left);
+        int cell = m_cells[k];
+        m_cells[k] = m_cells[--m_left];
+        return cell;
+    }
+
+    void recordAttackResult(int /* cell */, bool /* validShot */, bool /* shotHit */,
+                            bool /* shipDestroyed */, int /* shipId */)
+    {}
+
+  private:
+    RandomStream m_rng;
+    int m_left = 0;
+    int m_cells[R * C];
+};
+
+  // The two configurations the console game offers
+typedef FixedGame<10, 10, 5, 4, 3, 3, 2> StandardFixedGame;
+typedef FixedGame<2, 3, 2> RowboatFixedGame;
+
+#endif // FIXEDGAME_INCLUDED
@@ -0,0 +1,155 @@
+#include "FleetGenerator.h"
+#include "Game.h"
+#include "Board.h"
+#include "PlacementTable.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+      // Random probes tried before a ship's legal placements are enumerated
+    const int PROBES = 16;
+}
+
+FleetGenerator::FleetGenerator(const Game& g)
+ : m_game(g), m_rows(g.rows()), m_cols(g.cols()),
+   m_occupied((size_t(g.rows()) * g.cols() + 63) / 64, 0), m_retries(0), m_nodes(0)
+{
+    for (int s = 0; s < g.nShips(); s++)
+        m_order.push_back(s);
+    stable_sort(m_order.begin(), m_order.end(), [&g](int a, int b) {
+        return g.shipLength(a) > g.shipLength(b);
+    });
+}
+
+bool FleetGenerator::generate(RandomStream& rs, vector<ShipPlacement>& layout)
+{
+    fill(m_occupied.begin(), m_occupied.end(), 0);
+    m_retries = 0;
+    m_nodes = 0;
+    layout.assign(m_game.nShips(), ShipPlacement());
+    return placeFrom(0, rs, layout);
+}
+
+bool FleetGenerator::placeFleet(Board& b, RandomStream& rs)
+{
+    vector<ShipPlacement> layout;
+    bool generated = generate(rs, layout);
+    b.addPlacementRetries(m_retries);
+    if (!generated)
+        return false;
+    for (size_t s = 0; s < layout.size(); s++)
+    {
+        if (!b.placeShip(layout[s].topOrLeft, s, layout[s].dir))
+        {
+            b.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FleetGenerator::placeFrom(int depth, RandomStream& rs, vector<ShipPlacement>& layout)
+{
+    if (depth == int(m_order.size()))
+        return true;
+    int shipId = m_order[depth];
+    int length = m_game.shipLength(shipId);
+
+      // A uniform probe that lands on a legal placement is a uniform draw
+      // from the legal set, and on a sparse board one almost always does
+    Candidate probed = { 0, 0 };
+    for (int k = 0; k < PROBES; k++)
+    {
+        Candidate cand = randomCandidate(length, rs);
+        if (fits(cand, length))
+        {
+            if (++m_nodes > FLEET_NODE_BUDGET)
+                return false;
+            mark(cand, length, true);
+            if (placeFrom(depth + 1, rs, layout))
+            {
+                record(cand, shipId, length, layout);
+                return true;
+            }
+            mark(cand, length, false);
+            m_retries++;
+            probed = cand;
+            break;
+        }
+        m_retries++;
+    }
+
+      // Crowded board, or the probed placement led to a dead end: draw from
+      // the rest of the legal set without replacement until one works out
+    vector<Candidate> legal;
+    int n = placementCount(m_rows, m_cols, length);
+    for (int i = 0; i < n; i++)
+    {
+        Candidate cand = { placementStart(m_rows, m_cols, length, i),
+                           placementStep(m_rows, m_cols, length, i) };
+        if (fits(cand, length) && (cand.start != probed.start || cand.step != probed.step))
+            legal.push_back(cand);
+    }
+    while (!legal.empty())
+    {
+        if (++m_nodes > FLEET_NODE_BUDGET)
+            return false;
+        int k = rs.below(legal.size());
+        Candidate cand = legal[k];
+        legal[k] = legal.back();
+        legal.pop_back();
+        mark(cand, length, true);
+        if (placeFrom(depth + 1, rs, layout))
+        {
+            record(cand, shipId, length, layout);
+            return true;
+        }
+        mark(cand, length, false);
+        m_retries++;
+    }
+    return false;
+}
+
+  // A placement drawn uniformly from all placements of the given length
+FleetGenerator::Candidate FleetGenerator::randomCandidate(int length, RandomStream& rs) const
+{
+    Candidate cand = { 0, 0 };
+    int n = placementCount(m_rows, m_cols, length);
+    if (n == 0)
+        return cand;
+    int i = rs.below(n);
+    cand.start = placementStart(m_rows, m_cols, length, i);
+    cand.step = placementStep(m_rows, m_cols, length, i);
+    return cand;
+}
+
+bool FleetGenerator::fits(Candidate cand, int length) const
+{
+    if (cand.step == 0)
+        return false;
+    for (int k = 0, cell = cand.start; k < length; k++, cell += cand.step)
+        if ((m_occupied[cell >> 6] >> (cell & 63)) & 1)
+            return false;
+    return true;
+}
+
+void FleetGenerator::mark(Candidate cand, int length, bool occupied)
+{
+    for (int k = 0, cell = cand.start; k < length; k++, cell += cand.step)
+    {
+        if (occupied)
+            m_occupied[cell >> 6] |= uint64_t(1) << (cell & 63);
+        else
+            m_occupied[cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+    }
+}
+
+void FleetGenerator::record(Candidate cand, int shipId, int length,
+                            vector<ShipPlacement>& layout) const
+{
+    layout[shipId].topOrLeft = Point(cand.start / m_cols, cand.start % m_cols);
+      // On a one-column board a vertical ship also has step 1
+    layout[shipId].dir = (cand.step == 1 && length <= m_cols ? HORIZONTAL : VERTICAL);
+}
@@ -0,0 +1,70 @@
+#ifndef FLEETGENERATOR_INCLUDED
+#define FLEETGENERATOR_INCLUDED
+
+#include "globals.h"
+#include <vector>
+#include <cstdint>
+
+class Game;
+class Board;
+
+struct ShipPlacement
+{
+    Point topOrLeft;
+    Direction dir = HORIZONTAL;
+};
+
+  // Draws random legal layouts of a game's whole fleet.  Ships go down
+  // longest first; each one takes a placement drawn uniformly from those
+  // still legal, found by a few random probes and, when the board is too
+  // crowded for probing, by enumerating the legal set.  If a ship has no
+  // legal placement left the generator backs up and tries the previous
+  // ship's remaining placements.
+  //
+  // The draw is not uniform over layouts: each ship is uniform given the
+  // ships placed before it, so a placement of a long ship that leaves the
+  // others few ways to fit is as likely as one that leaves them many.
+  // The backtracking search can take exponential time on a fleet that
+  // barely fits, so it tries at most FLEET_NODE_BUDGET placements per
+  // layout; generate then fails with budgetExhausted() true, and without
+  // it generate fails only when no layout exists.
+const long FLEET_NODE_BUDGET = 100000;
+
+class FleetGenerator
+{
+  public:
+    FleetGenerator(const Game& g);
+      // Fill layout (indexed by shipId) with a random legal layout
+    bool generate(RandomStream& rs, std::vector<ShipPlacement>& layout);
+      // Generate a layout and place it on an empty board
+    bool placeFleet(Board& b, RandomStream& rs);
+      // Probes that missed plus placements backed out of by the last
+      // generate; placeFleet adds them to the board's placementRetries
+    int retries() const { return m_retries; }
+      // Whether the last generate gave up after FLEET_NODE_BUDGET
+      // placements rather than finding that no layout exists
+    bool budgetExhausted() const { return m_nodes > FLEET_NODE_BUDGET; }
+
+  private:
+    struct Candidate
+    {
+        int start;
+        int step;
+    };
+    bool placeFrom(int depth, RandomStream& rs, std::vector<ShipPlacement>& layout);
+    Candidate randomCandidate(int length, RandomStream& rs) const;
+    bool fits(Candidate cand, int length) const;
+    void mark(Candidate cand, int length, bool occupied);
+    void record(Candidate cand, int shipId, int length,
+                std::vector<ShipPlacement>& layout) const;
+
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    std::vector<int> m_order;         // shipIds, longest first
+    std::vector<uint64_t> m_occupied; // one bit per cell
+    int m_retries;
+    long m_nodes;                     // placements tried by the last generate
+};
+
+#endif // FLEETGENERATOR_INCLUDED
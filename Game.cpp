@@ -2,11 +2,21 @@
 #include "Board.h"
 #include "Player.h"
 #include "globals.h"
+#include "GameSink.h"
+#include "Instrument.h"
+#include "ShotSelector.h"
+#include "ReplayLog.h"
+#include "Renderer.h"
+#include "Timer.h"
 #include <vector>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <memory>
+#include <limits>
+#include <algorithm>
 
 using namespace std;
 
@@ -18,12 +28,21 @@ class GameImpl
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
+    void setSeed(uint64_t seed, uint64_t gameIndex);
+    uint64_t seed() const { return mSeed; }
+    uint64_t gameIndex() const { return mGameIndex; }
+    RandomStream randomStream(int streamId) const;
+    void setTimeBudget(double moveMs, double gameMs, OverrunPolicy policy);
+    void setPhaseTiming(bool on);
+    void setDisplayMode(DisplayMode mode);
+    DisplayMode displayMode() const;
     bool addShip(int length, char symbol, string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    GameResult play(Player* p1, Player* p2, Board& b1, Board& b2,
+                    GameSink* sink, bool recordEvents);
 private:
     struct ship 
     {
@@ -35,6 +54,14 @@ private:
     vector<ship> shipVector;
     int mRows;
     int mCols;
+    uint64_t mSeed;
+    uint64_t mGameIndex;
+    mutable RandomStream mRng;   // drawn from by randomPoint()
+    double mMoveMs;              // time budgets, 0 for none
+    double mGameMs;
+    OverrunPolicy mOverrunPolicy;
+    bool mPhaseTiming;
+    DisplayMode mDisplayMode;
 };
 
 void waitForEnter()
@@ -43,7 +70,18 @@ void waitForEnter()
     cin.ignore(10000, '\n');
 }
 
-GameImpl::GameImpl(int nRows, int nCols) : mRows(nRows), mCols(nCols)
+  // Player::placeShips, timed when instrumentation is compiled in
+bool placeFleet(Player* p, Board& b)
+{
+    BSIM_PROBE(PROBE_PLACE_SHIPS);
+    return p->placeShips(b);
+}
+
+GameImpl::GameImpl(int nRows, int nCols)
+    : mRows(nRows), mCols(nCols), mSeed(entropySeed()), mGameIndex(0),
+      mRng(mSeed, mGameIndex, GAME_STREAM), mMoveMs(0), mGameMs(0),
+      mOverrunPolicy(OVERRUN_FALLBACK), mPhaseTiming(false),
+      mDisplayMode(DISPLAY_PLAIN)
 {}
 
 int GameImpl::rows() const
@@ -63,7 +101,42 @@ bool GameImpl::isValid(Point p) const
 
 Point GameImpl::randomPoint() const
 {
-    return Point(randInt(rows()), randInt(cols()));
+    int r = mRng.below(rows());
+    return Point(r, mRng.below(cols()));
+}
+
+void GameImpl::setSeed(uint64_t seed, uint64_t gameIndex)
+{
+    mSeed = seed;
+    mGameIndex = gameIndex;
+    mRng = RandomStream(seed, gameIndex, GAME_STREAM);
+}
+
+RandomStream GameImpl::randomStream(int streamId) const
+{
+    return RandomStream(mSeed, mGameIndex, streamId);
+}
+
+void GameImpl::setTimeBudget(double moveMs, double gameMs, OverrunPolicy policy)
+{
+    mMoveMs = max(moveMs, 0.0);
+    mGameMs = max(gameMs, 0.0);
+    mOverrunPolicy = policy;
+}
+
+void GameImpl::setPhaseTiming(bool on)
+{
+    mPhaseTiming = on;
+}
+
+void GameImpl::setDisplayMode(DisplayMode mode)
+{
+    mDisplayMode = mode;
+}
+
+DisplayMode GameImpl::displayMode() const
+{
+    return mDisplayMode;
 }
 
 bool GameImpl::addShip(int length, char symbol, string name)  
@@ -101,71 +174,200 @@ string GameImpl::shipName(int shipId) const
     return shipVector.at(shipId).mName;
 }
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+GameResult GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2,
+                          GameSink* sink, bool recordEvents)
 {
-    if (!p1->placeShips(b1) || !p2->placeShips(b2)) { return nullptr; }
+    GameResult result;
+    Timer gameTimer;
+    b1.setRandomStream(randomStream(BOARD1_STREAM));
+    b2.setRandomStream(randomStream(BOARD2_STREAM));
+    p1->setRandomStream(randomStream(PLAYER1_STREAM));
+    p2->setRandomStream(randomStream(PLAYER2_STREAM));
+    p1->setDeadline(Deadline());
+    p2->setDeadline(Deadline());
+    Player* players[2] = { p1, p2 };
+    Board* boards[2] = { &b1, &b2 };
+    for (int s = 0; s < 2; s++)
+    {
+        Timer t;
+        bool placed = placeFleet(players[s], *boards[s]);
+        if (mPhaseTiming) { result.placeMs[s] = t.elapsed(); }
+        result.placeRetries[s] = boards[s]->placementRetries();
+        if (!placed) { return result; }
+    }
+    if (sink) { sink->shipsPlaced(b1, b2); }
     // game play starts
+    // Only the board just attacked can change, so the game-over test is
+    // one check of that board per shot rather than both boards per turn.
+    bool over = b1.allShipsDestroyed() || b2.allShipsDestroyed();
     int k = 0;
-    while (!b1.allShipsDestroyed() && !b2.allShipsDestroyed()) 
+      // With a time budget, each move is timed against what its player has
+      // left, and the referee tracks the cells each side hasn't fired at so
+      // it can substitute a shot for a move that runs over
+    bool timed = (mMoveMs > 0 || mGameMs > 0);
+    double spent[2] = { 0, 0 };
+    unique_ptr<CellPool> untried[2];
+    RandomStream fallbackRng = randomStream(GAME_STREAM).substream(0);
+    if (timed && mOverrunPolicy == OVERRUN_FALLBACK)
     {
-        bool shotHit = false;
-        bool shipDestroyed = false;
-        bool valid = false;
-        int shipId = -1;
-        if (k % 2 == 0) //p1 plays
+        untried[0].reset(new CellPool(mRows, mCols));
+        untried[1].reset(new CellPool(mRows, mCols));
+    }
+    double turnEnd = (mPhaseTiming ? gameTimer.elapsed() : 0);
+    while (!over)
+    {
+        int a = k % 2;
+        Player* attacker = players[a];
+        Player* defender = players[1 - a];
+        Board& target = *boards[1 - a];
+        if (sink) { sink->turnStarted(*attacker, *defender, target); }
+        ShotEvent e;
+        e.shooter = a;
+        if (!timed)
         {
-            bool isHuman = p1->isHuman();
-            cout << p1->name() << "'s turn. Board for " << p2->name() << ":" << endl;
-            b2.display(isHuman);
-            Point p = p1->recommendAttack();
-            valid = b2.attack(p, shotHit, shipDestroyed, shipId);
-            p1->recordAttackResult(p, valid, shotHit, shipDestroyed, shipId);
-            if (p1->isHuman() && valid == false)
-            { cout << p1->name() << " wasted a shot at (" << p.r << "," << p.c << ")." << endl; }
-            else 
-            {
-                cout << p1->name() << " attacked (" << p.r << "," << p.c << ") and ";
-                if (shotHit)
-                {
-                    if (shipDestroyed) { cout << "destroyed the " << this->shipName(shipId); }
-                    else { cout << "hit something"; }
-                }
-                else { cout << "missed"; }
-                cout << " , resulting in:" << endl;
-            }
-            b2.display(isHuman);
+            BSIM_PROBE(PROBE_RECOMMEND_ATTACK);
+            e.p = attacker->recommendAttack();
         }
-        if (k % 2 == 1) //p2 plays
+        else
         {
-            bool isHuman = p2->isHuman();
-            cout << p2->name() << "'s turn. Board for " << p1->name() << ":" << endl;
-            b1.display(isHuman);
-            Point p = p2->recommendAttack();
-            valid = b1.attack(p, shotHit, shipDestroyed, shipId);
-            p2->recordAttackResult(p, valid, shotHit, shipDestroyed, shipId);
-            if (p2->isHuman() && valid == false)
-            { cout << p2->name() << " wasted a shot at (" << p.r << "," << p.c << ")." << endl; }
-            else
+            double allowed = numeric_limits<double>::infinity();
+            if (mMoveMs > 0) { allowed = mMoveMs; }
+            if (mGameMs > 0) { allowed = min(allowed, max(mGameMs - spent[a], 0.0)); }
+            attacker->setDeadline(Deadline(allowed));
+            Timer t;
             {
-                cout << p2->name() << " attacked (" << p.r << "," << p.c << ") and ";
-                if (shotHit)
-                {
-                    if (shipDestroyed) { cout << "destroyed the " << this->shipName(shipId); }
-                    else { cout << "hit something"; }
-                }
-                else { cout << "missed"; }
-                cout << " , resulting in:" << endl;
+                BSIM_PROBE(PROBE_RECOMMEND_ATTACK);
+                e.p = attacker->recommendAttack();
             }
-            b1.display(isHuman);
+            double took = t.elapsed();
+            spent[a] += took;
+            e.overran = (took > allowed);
+        }
+        if (e.overran)
+        {
+            result.overruns[a]++;
+            if (mOverrunPolicy == OVERRUN_FALLBACK) { e.p = untried[a]->drawPoint(fallbackRng); }
+        }
+        if (!e.overran || mOverrunPolicy == OVERRUN_FALLBACK)
+        {
+            e.validShot = target.attack(e.p, e.shotHit, e.shipDestroyed, e.shipId);
+        }
+        if (untried[a] && e.validShot) { untried[a]->remove(e.p); }
+        {
+            BSIM_PROBE(PROBE_RECORD_ATTACK_RESULT);
+            attacker->recordAttackResult(e.p, e.validShot, e.shotHit, e.shipDestroyed, e.shipId);
+        }
+        BSIM_COUNT(COUNTER_SHOTS, 1);
+        BSIM_COUNT(COUNTER_HITS, e.shotHit);
+        defender->recordAttackByOpponent(e.p);
+        result.shots[a]++;
+        if (recordEvents) { result.events.push_back(e); }
+        if (sink) { sink->shotFired(*attacker, e, target); }
+        over = target.allShipsDestroyed();
+        if (mPhaseTiming)
+        {
+              // One clock read a turn: each turn runs from the end of the last
+            double now = gameTimer.elapsed();
+            result.moveMs[a] += now - turnEnd;
+            turnEnd = now;
         }
-        if (shouldPause) { waitForEnter(); }
         k++;
     }
-    if (b1.allShipsDestroyed()) { cout << p2->name() << " wins!" << endl; return p2; }
-    else if (b2.allShipsDestroyed()) { cout << p1->name() << " wins!" << endl; return p1; }
-    else { return nullptr; }
+    result.winnerIndex = b1.allShipsDestroyed() ? 1 : 0;
+    result.winner = players[result.winnerIndex];
+    if (mPhaseTiming) { result.elapsedMs = turnEnd; }
+    if (sink) { sink->gameOver(result.winner); }
+    return result;
+}
+
+//******************** ConsoleSink functions *************************
+
+ConsoleSink::ConsoleSink(const Game& g, bool shouldPause, DisplayMode mode)
+ : m_game(g), m_shouldPause(shouldPause)
+{
+    if (mode == DISPLAY_ANSI)
+        m_frame.reset(new FrameRenderer(cout, true));
+}
+
+ConsoleSink::~ConsoleSink()
+{}
+
+void ConsoleSink::shipsPlaced(const Board& b1, const Board& b2)
+{
+    m_boards[0] = &b1;
+    m_boards[1] = &b2;
+}
+
+void ConsoleSink::turnStarted(const Player& attacker, const Player& defender, const Board& target)
+{
+    if (m_frame)
+    {
+        m_attacker = &attacker;
+        m_defender = &defender;
+        m_target = &target;
+        showBoards(attacker.name() + "'s turn.");
+        return;
+    }
+    cout << attacker.name() << "'s turn. Board for " << defender.name() << ":" << endl;
+    target.display(attacker.isHuman());
+}
+
+void ConsoleSink::shotFired(const Player& attacker, const ShotEvent& e, const Board& target)
+{
+    if (m_frame) { showBoards(describeShot(attacker, e) + "."); }
+    else
+    {
+        cout << describeShot(attacker, e);
+        if (!attacker.isHuman() || e.validShot) { cout << " , resulting in:"; }
+        cout << endl;
+        target.display(attacker.isHuman());
+    }
+    if (m_shouldPause) { waitForEnter(); }
+}
+
+void ConsoleSink::gameOver(const Player* winner)
+{
+    if (m_frame && m_target != nullptr)
+    {
+        showBoards(winner->name() + " wins!");
+        return;
+    }
+    cout << winner->name() << " wins!" << endl;
 }
 
+string ConsoleSink::describeShot(const Player& attacker, const ShotEvent& e) const
+{
+    ostringstream text;
+    if (e.overran) { text << attacker.name() << " ran over its time budget." << '\n'; }
+    if (attacker.isHuman() && !e.validShot)
+    { text << attacker.name() << " wasted a shot at (" << e.p.r << "," << e.p.c << ")."; }
+    else
+    {
+        text << attacker.name() << " attacked (" << e.p.r << "," << e.p.c << ") and ";
+        if (e.shotHit)
+        {
+            if (e.shipDestroyed) { text << "destroyed the " << m_game.shipName(e.shipId); }
+            else { text << "hit something"; }
+        }
+        else { text << "missed"; }
+    }
+    return text.str();
+}
+
+  // Draw both boards, seat 1's on the left, with status beneath.  A board
+  // shows its ships unless its owner's opponent is human.
+void ConsoleSink::showBoards(const string& status)
+{
+    int t = (m_target == m_boards[1] ? 1 : 0);
+    const Player* owner[2];
+    owner[t] = m_defender;
+    owner[1 - t] = m_attacker;
+    m_frame->clear();
+    m_frame->addBoards("Board for " + owner[0]->name() + ":", *m_boards[0], owner[1]->isHuman(),
+                       "Board for " + owner[1]->name() + ":", *m_boards[1], owner[0]->isHuman());
+    m_frame->addText(status);
+    m_frame->present();
+}
 
 //******************** Game functions *******************************
 
@@ -212,6 +414,46 @@ Point Game::randomPoint() const
     return m_impl->randomPoint();
 }
 
+void Game::setSeed(uint64_t seed, uint64_t gameIndex)
+{
+    m_impl->setSeed(seed, gameIndex);
+}
+
+uint64_t Game::seed() const
+{
+    return m_impl->seed();
+}
+
+uint64_t Game::gameIndex() const
+{
+    return m_impl->gameIndex();
+}
+
+RandomStream Game::randomStream(int streamId) const
+{
+    return m_impl->randomStream(streamId);
+}
+
+void Game::setTimeBudget(double moveMs, double gameMs, OverrunPolicy policy)
+{
+    m_impl->setTimeBudget(moveMs, gameMs, policy);
+}
+
+void Game::setPhaseTiming(bool on)
+{
+    m_impl->setPhaseTiming(on);
+}
+
+void Game::setDisplayMode(DisplayMode mode)
+{
+    m_impl->setDisplayMode(mode);
+}
+
+DisplayMode Game::displayMode() const
+{
+    return m_impl->displayMode();
+}
+
 bool Game::addShip(int length, char symbol, string name)
 {
     if (length < 1)
@@ -279,12 +521,48 @@ string Game::shipName(int shipId) const
     return m_impl->shipName(shipId);
 }
 
-Player* Game::play(Player* p1, Player* p2, bool shouldPause)
+Player* Game::play(Player* p1, Player* p2, bool shouldPause, ReplayLog* log)
 {
     if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
         return nullptr;
+    ConsoleSink sink(*this, shouldPause, m_impl->displayMode());
+    if (log == nullptr)
+        return simulate(p1, p2, &sink, false).winner;
+    ReplayRecorder recorder(*log, *this);
+    TeeSink tee(sink, recorder);
+    return simulate(p1, p2, &tee, false).winner;
+}
+
+GameResult Game::simulate(Player* p1, Player* p2, GameSink* sink, bool recordEvents)
+{
+    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+        return GameResult();
     Board b1(*this);
     Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    return m_impl->play(p1, p2, b1, b2, sink, recordEvents);
+}
+
+bool addStandardShips(Game& g)
+{
+    return g.addShip(5, 'A', "aircraft carrier")  &&
+           g.addShip(4, 'B', "battleship")  &&
+           g.addShip(3, 'D', "destroyer")  &&
+           g.addShip(3, 'S', "submarine")  &&
+           g.addShip(2, 'P', "patrol boat");
 }
 
+bool addShips(Game& g, const vector<int>& lengths)
+{
+    static const char symbols[] = "ABCDEFGHIJKLMNOPQRSTUVWYZ"
+                                  "abcdefghijklmnpqrstuvwxyz"
+                                  "0123456789";
+    static_assert(sizeof(symbols) - 1 == MAX_SHIPS, "one symbol per ship");
+    if (lengths.size() > size_t(MAX_SHIPS))
+        return false;
+    for (size_t k = 0; k < lengths.size(); k++)
+    {
+        if (!g.addShip(lengths[k], symbols[k], "ship " + to_string(k + 1)))
+            return false;
+    }
+    return true;
+}
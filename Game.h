@@ -2,11 +2,29 @@
 #define GAME_INCLUDED
 
 #include <string>
+#include <vector>
 #include <cassert>
+#include <cstdint>
 
 class Point;
 class Player;
 class GameImpl;
+class RandomStream;
+class GameSink;
+class ReplayLog;
+struct GameResult;
+
+  // How Game::play shows a game on the console
+enum DisplayMode {
+    DISPLAY_PLAIN,      // the target board after every turn and shot, scrolling
+    DISPLAY_ANSI        // both boards side by side, redrawn in place
+};
+
+  // What the referee does with a move that took longer than its budget
+enum OverrunPolicy {
+    OVERRUN_FALLBACK,   // fire at a random cell the player hasn't tried instead
+    OVERRUN_FORFEIT     // the player loses the shot
+};
 
 class Game
 {
@@ -17,12 +35,30 @@ class Game
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
+      // Key every random draw of the next game to (seed, gameIndex)
+    void setSeed(uint64_t seed, uint64_t gameIndex);
+    uint64_t seed() const;
+    uint64_t gameIndex() const;
+    RandomStream randomStream(int streamId) const;
+      // Give each player at most moveMs per move and gameMs for all its
+      // moves in a game; 0 means no limit, which is the default
+    void setTimeBudget(double moveMs, double gameMs, OverrunPolicy policy = OVERRUN_FALLBACK);
+      // Time ship placement and every turn, reporting the totals in each
+      // GameResult; off by default, since it reads the clock once a shot
+    void setPhaseTiming(bool on);
+    void setDisplayMode(DisplayMode mode);
+    DisplayMode displayMode() const;
     bool addShip(int length, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     std::string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, bool shouldPause = true);
+      // If log is given, the game is also appended to it
+    Player* play(Player* p1, Player* p2, bool shouldPause = true, ReplayLog* log = nullptr);
+      // Play without any output unless a sink is given; recordEvents keeps
+      // every shot in the returned GameResult
+    GameResult simulate(Player* p1, Player* p2, GameSink* sink = nullptr,
+                        bool recordEvents = true);
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
@@ -31,4 +67,14 @@ class Game
     GameImpl* m_impl;
 };
 
+  // Add the five ships of the classic 10x10 game
+bool addStandardShips(Game& g);
+  // The most ships addShips has symbols for
+const int MAX_SHIPS = 60;
+
+  // Add a ship of each of the given lengths, marked A to Z, then a to z,
+  // then 0 to 9, in order, skipping the X and o the board uses for shots;
+  // false if there are more than MAX_SHIPS or the fleet doesn't fit
+bool addShips(Game& g, const std::vector<int>& lengths);
+
 #endif // GAME_INCLUDED
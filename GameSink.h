@@ -0,0 +1,100 @@
+#ifndef GAMESINK_INCLUDED
+#define GAMESINK_INCLUDED
+
+#include "globals.h"
+#include "Game.h"
+#include <vector>
+#include <string>
+#include <memory>
+
+class Player;
+class Board;
+class FrameRenderer;
+
+  // One shot of a game, as seen by the referee
+struct ShotEvent
+{
+    int shooter = 0;        // 0 for the first player, 1 for the second
+    Point p;
+    bool validShot = false;
+    bool shotHit = false;
+    bool shipDestroyed = false;
+    int shipId = -1;        // the ship hit, or -1 on a miss
+    bool overran = false;   // the move ran over its time budget
+};
+
+  // What Game::simulate reports when a game ends
+struct GameResult
+{
+    Player* winner = nullptr;     // nullptr if a player failed to place ships
+    int winnerIndex = -1;         // 0 or 1, matching ShotEvent::shooter
+    int shots[2] = { 0, 0 };      // shots fired by each side
+    int overruns[2] = { 0, 0 };   // moves each side took over its time budget
+    int placeRetries[2] = { 0, 0 };  // see Board::placementRetries
+      // With Game::setPhaseTiming, milliseconds each side spent placing its
+      // ships and taking its turns (choosing a move, the shot and its
+      // bookkeeping), and the whole game's wall time
+    double placeMs[2] = { 0, 0 };
+    double moveMs[2] = { 0, 0 };
+    double elapsedMs = 0;
+    std::vector<ShotEvent> events;  // every shot in order, if requested
+};
+
+  // Receives the progress of a game.  Game::simulate calls these as the game
+  // unfolds; with no sink attached nothing is formatted or written at all.
+class GameSink
+{
+  public:
+    virtual ~GameSink() {}
+    virtual void shipsPlaced(const Board& /* b1 */, const Board& /* b2 */) {}
+    virtual void turnStarted(const Player& /* attacker */, const Player& /* defender */,
+                             const Board& /* target */) {}
+    virtual void shotFired(const Player& /* attacker */, const ShotEvent& /* e */,
+                           const Board& /* target */) {}
+    virtual void gameOver(const Player* /* winner */) {}
+};
+
+  // The console narration Game::play has always produced, or in
+  // DISPLAY_ANSI mode the same narration under both boards, redrawn in place
+class ConsoleSink : public GameSink
+{
+  public:
+    ConsoleSink(const Game& g, bool shouldPause, DisplayMode mode = DISPLAY_PLAIN);
+    virtual ~ConsoleSink();
+    virtual void shipsPlaced(const Board& b1, const Board& b2);
+    virtual void turnStarted(const Player& attacker, const Player& defender, const Board& target);
+    virtual void shotFired(const Player& attacker, const ShotEvent& e, const Board& target);
+    virtual void gameOver(const Player* winner);
+  private:
+    std::string describeShot(const Player& attacker, const ShotEvent& e) const;
+    void showBoards(const std::string& status);
+
+    const Game& m_game;
+    bool m_shouldPause;
+    std::unique_ptr<FrameRenderer> m_frame;  // null in plain mode
+    const Board* m_boards[2] = { nullptr, nullptr };
+    const Player* m_attacker = nullptr;      // of the turn in progress
+    const Player* m_defender = nullptr;
+    const Board* m_target = nullptr;
+};
+
+  // Passes everything on to two sinks, for watching and recording a game
+  // at once
+class TeeSink : public GameSink
+{
+  public:
+    TeeSink(GameSink& first, GameSink& second) : m_first(first), m_second(second) {}
+    virtual void shipsPlaced(const Board& b1, const Board& b2)
+    { m_first.shipsPlaced(b1, b2); m_second.shipsPlaced(b1, b2); }
+    virtual void turnStarted(const Player& attacker, const Player& defender, const Board& target)
+    { m_first.turnStarted(attacker, defender, target); m_second.turnStarted(attacker, defender, target); }
+    virtual void shotFired(const Player& attacker, const ShotEvent& e, const Board& target)
+    { m_first.shotFired(attacker, e, target); m_second.shotFired(attacker, e, target); }
+    virtual void gameOver(const Player* winner)
+    { m_first.gameOver(winner); m_second.gameOver(winner); }
+  private:
+    GameSink& m_first;
+    GameSink& m_second;
+};
+
+#endif // GAMESINK_INCLUDED
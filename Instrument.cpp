@@ -0,0 +1,166 @@
+#include "Instrument.h"
+
+#ifdef BSIM_INSTRUMENT
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+std::atomic<bool> g_probeTracing(false);
+
+namespace
+{
+    const char* const PROBE_NAMES[PROBE_COUNT] = {
+        "placeShips", "recommendAttack", "recordAttackResult", "Board::attack", "display"
+    };
+    const char* const COUNTER_NAMES[COUNTER_COUNT] = {
+        "shots", "hits", "placeShip failures"
+    };
+
+    struct Registry
+    {
+        Registry()
+         : startTicks(probeTicks()), startTime(chrono::steady_clock::now())
+        {}
+
+          // Cycle-counter ticks per nanosecond, measured against the steady
+          // clock over the life of the program so far
+        double ticksPerNs() const
+        {
+            double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - startTime).count();
+            double ticks = double(probeTicks() - startTicks);
+            return (ns > 0 && ticks > 0) ? ticks / ns : 1;
+        }
+
+        mutex m;
+        vector<unique_ptr<ProbeThread>> threads;
+        uint64_t startTicks;
+        chrono::steady_clock::time_point startTime;
+    };
+
+    Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+
+      // The value below which the fraction q of the recorded values fall
+    uint64_t percentile(const ProbeHistogram& h, double q)
+    {
+        uint64_t target = uint64_t(q * h.count);
+        uint64_t seen = 0;
+        for (int b = 0; b < ProbeHistogram::BUCKETS; b++)
+        {
+            seen += h.buckets[b];
+            if (seen > target)
+                return ProbeHistogram::lowest(b);
+        }
+        return h.max;
+    }
+}
+
+ProbeThread* registerProbeThread()
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    r.threads.emplace_back(new ProbeThread);
+    r.threads.back()->tid = int(r.threads.size());
+    return r.threads.back().get();
+}
+
+void setProbeTracing(bool on)
+{
+    registry();  // start the clock calibration no later than the first span
+    g_probeTracing.store(on);
+}
+
+void resetProbes()
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    for (unique_ptr<ProbeThread>& t : r.threads)
+    {
+        int tid = t->tid;
+        t->ring.clear();
+        *t = ProbeThread();
+        t->tid = tid;
+    }
+}
+
+void writeProbeReport(ostream& out)
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    double perNs = r.ticksPerNs();
+    out << left << setw(20) << "probe" << right << setw(12) << "count"
+        << setw(10) << "mean ns" << setw(10) << "p50" << setw(10) << "p90"
+        << setw(10) << "p99" << setw(10) << "p99.9" << setw(12) << "max" << '\n';
+    for (int p = 0; p < PROBE_COUNT; p++)
+    {
+        ProbeHistogram h;
+        for (const unique_ptr<ProbeThread>& t : r.threads)
+        {
+            const ProbeHistogram& th = t->histograms[p];
+            h.count += th.count;
+            h.total += th.total;
+            h.max = max(h.max, th.max);
+            for (int b = 0; b < ProbeHistogram::BUCKETS; b++)
+                h.buckets[b] += th.buckets[b];
+        }
+        if (h.count == 0)
+            continue;
+        out << left << setw(20) << PROBE_NAMES[p] << right << setw(12) << h.count
+            << fixed << setprecision(0)
+            << setw(10) << h.total / perNs / h.count
+            << setw(10) << percentile(h, 0.5) / perNs
+            << setw(10) << percentile(h, 0.9) / perNs
+            << setw(10) << percentile(h, 0.99) / perNs
+            << setw(10) << percentile(h, 0.999) / perNs
+            << setw(12) << h.max / perNs << defaultfloat << '\n';
+    }
+    for (int c = 0; c < COUNTER_COUNT; c++)
+    {
+        uint64_t total = 0;
+        for (const unique_ptr<ProbeThread>& t : r.threads)
+            total += t->counters[c];
+        out << left << setw(20) << COUNTER_NAMES[c] << right << setw(12) << total << '\n';
+    }
+}
+
+bool writeChromeTrace(const string& path)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    double perUs = r.ticksPerNs() * 1000;
+    out << "{\"traceEvents\":[" << fixed << setprecision(3);
+    bool first = true;
+    for (const unique_ptr<ProbeThread>& t : r.threads)
+    {
+        if (t->ring.empty())
+            continue;
+          // Oldest span first; a full ring has overwritten the earliest ones
+        uint64_t n = min<uint64_t>(t->spansWritten, ProbeThread::RING_SPANS);
+        for (uint64_t k = t->spansWritten - n; k < t->spansWritten; k++)
+        {
+            const ProbeSpan& s = t->ring[k % ProbeThread::RING_SPANS];
+            out << (first ? "\n" : ",\n")
+                << "{\"name\":\"" << PROBE_NAMES[s.probe] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << t->tid << ",\"ts\":" << double(int64_t(s.start - r.startTicks)) / perUs
+                << ",\"dur\":" << double(s.end - s.start) / perUs << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return bool(out);
+}
+
+#endif // BSIM_INSTRUMENT
@@ -0,0 +1,175 @@
+#ifndef INSTRUMENT_INCLUDED
+#define INSTRUMENT_INCLUDED
+
+// Hot-path instrumentation, compiled in only when BSIM_INSTRUMENT is
+// defined, e.g. make CXXFLAGS="-std=c++20 -O2 -DBSIM_INSTRUMENT".
+//
+//     BSIM_PROBE(PROBE_BOARD_ATTACK);       // time the rest of this scope
+//     BSIM_COUNT(COUNTER_PLACE_FAILURES, 1);
+//
+// Without BSIM_INSTRUMENT both macros expand to nothing.  With it, a probe
+// reads the cycle counter on entry and exit and adds the duration to a
+// histogram owned by the calling thread, so probes never contend; when
+// tracing is on, the span also goes into that thread's ring buffer of the
+// most recent spans, for export in Chrome's trace-event format.
+
+#include <iosfwd>
+#include <string>
+
+enum ProbeId {
+    PROBE_PLACE_SHIPS, PROBE_RECOMMEND_ATTACK, PROBE_RECORD_ATTACK_RESULT,
+    PROBE_BOARD_ATTACK, PROBE_DISPLAY, PROBE_COUNT
+};
+
+enum CounterId {
+    COUNTER_SHOTS, COUNTER_HITS, COUNTER_PLACE_FAILURES, COUNTER_COUNT
+};
+
+#ifdef BSIM_INSTRUMENT
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+  // Timestamps are in ticks of the cycle counter where there is one and in
+  // nanoseconds elsewhere; reports convert ticks to nanoseconds
+inline uint64_t probeTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+  // A log-linear histogram in the style of HdrHistogram: values below 16
+  // get a bucket each, and every power of two above that is split into 16
+  // buckets, so any value is recorded to within 1/16 of itself.
+struct ProbeHistogram
+{
+    static const int SUB_BUCKETS = 16;
+    static const int BUCKETS = (64 - 3) * SUB_BUCKETS;
+
+    static int bucket(uint64_t v)
+    {
+        if (v < SUB_BUCKETS)
+            return int(v);
+        int e = 63 - __builtin_clzll(v);
+        return (e - 3) * SUB_BUCKETS + int((v >> (e - 4)) & (SUB_BUCKETS - 1));
+    }
+      // The smallest value that lands in bucket b
+    static uint64_t lowest(int b)
+    {
+        if (b < SUB_BUCKETS)
+            return b;
+        int e = b / SUB_BUCKETS + 3;
+        return uint64_t(SUB_BUCKETS + b % SUB_BUCKETS) << (e - 4);
+    }
+
+    void record(uint64_t v)
+    {
+        count++;
+        total += v;
+        if (v > max)
+            max = v;
+        buckets[bucket(v)]++;
+    }
+
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+    uint64_t buckets[BUCKETS] = {};
+};
+
+struct ProbeSpan
+{
+    uint64_t start;
+    uint64_t end;
+    int probe;
+};
+
+  // Everything one thread has recorded.  Only its own thread writes to it;
+  // reports read it once the instrumented work has finished.
+struct ProbeThread
+{
+    static const int RING_SPANS = 1 << 16;
+
+    int tid = 0;
+    ProbeHistogram histograms[PROBE_COUNT];
+    uint64_t counters[COUNTER_COUNT] = {};
+    std::vector<ProbeSpan> ring;    // allocated when tracing first records
+    uint64_t spansWritten = 0;
+};
+
+extern std::atomic<bool> g_probeTracing;
+
+  // Allocate and register the calling thread's record.  Records outlive
+  // their threads, so a report after a thread pool exits still sees them.
+ProbeThread* registerProbeThread();
+
+inline ProbeThread& probeThread()
+{
+    static thread_local ProbeThread* t = nullptr;
+    if (t == nullptr)
+        t = registerProbeThread();
+    return *t;
+}
+
+inline void recordProbe(ProbeId id, uint64_t start, uint64_t end)
+{
+    ProbeThread& t = probeThread();
+    t.histograms[id].record(end - start);
+    if (g_probeTracing.load(std::memory_order_relaxed))
+    {
+        if (t.ring.empty())
+            t.ring.resize(ProbeThread::RING_SPANS);
+        ProbeSpan& s = t.ring[t.spansWritten++ % ProbeThread::RING_SPANS];
+        s.start = start;
+        s.end = end;
+        s.probe = id;
+    }
+}
+
+class ScopedProbe
+{
+  public:
+    explicit ScopedProbe(ProbeId id) : m_id(id), m_start(probeTicks()) {}
+    ~ScopedProbe() { recordProbe(m_id, m_start, probeTicks()); }
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+  private:
+    ProbeId m_id;
+    uint64_t m_start;
+};
+
+#define BSIM_PROBE_JOIN2(a, b) a##b
+#define BSIM_PROBE_JOIN(a, b) BSIM_PROBE_JOIN2(a, b)
+#define BSIM_PROBE(id) ScopedProbe BSIM_PROBE_JOIN(bsimProbe, __LINE__)(id)
+#define BSIM_COUNT(id, n) (probeThread().counters[id] += (n))
+
+  // Turn recording of spans for trace export on or off
+void setProbeTracing(bool on);
+  // Forget everything recorded so far, on every thread
+void resetProbes();
+  // Print each probe's count and latency percentiles in nanoseconds, and
+  // the counters, summed over all threads
+void writeProbeReport(std::ostream& out);
+  // Write the spans still held in the ring buffers as a Chrome trace
+  // (chrome://tracing or ui.perfetto.dev); false if the file can't be
+  // written
+bool writeChromeTrace(const std::string& path);
+
+#else
+
+#define BSIM_PROBE(id) ((void)0)
+#define BSIM_COUNT(id, n) ((void)0)
+
+#endif // BSIM_INSTRUMENT
+
+#endif // INSTRUMENT_INCLUDED
@@ -0,0 +1,319 @@
+#include "Strategies.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include "FleetGenerator.h"
+#include "PlacementTable.h"
+#include "Bitboard.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+//*********************************************************************
+//  MonteCarloPlayer
+//*********************************************************************
+
+// Each move the player draws a batch of complete fleet layouts that agree
+// with everything it knows: no ship on a miss, the sunk ships exactly where
+// they went down, every unsunk hit covered, and no unsunk ship entirely
+// made of hits (it would have been reported sunk).  It fires at the unshot
+// cell occupied most often across the batch.  Layouts are built from the
+// 128-bit masks of the shared PlacementTables: unsunk hits are covered
+// first, each by a random ship placement through it, and the remaining
+// ships are then dropped at random on free cells.  The batch is split
+// into fixed chunks, each with its own random stream, so the choice
+// doesn't depend on how many threads ran the chunks.  When the game sets
+// a deadline for the move, the player ignores its sample count and keeps
+// adding chunks for as long as the time allows.
+
+class MonteCarloPlayer : public Player
+{
+  public:
+    MonteCarloPlayer(string nm, const Game& g, int samplesPerMove, int threads);
+    bool placeShips(Board& b);
+    Point recommendAttack();
+    void recordAttackResult(Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    void recordAttackByOpponent(Point /* p */) {}
+
+  private:
+    static const int CHUNK = 256;
+    bool sampleLayout(RandomStream& rs, Bitboard& layout) const;
+    void sampleChunk(const RandomStream& base, long chunk, long samples, vector<int>& counts) const;
+    void sampleChunks(const RandomStream& base, long first, long last, long samples,
+                      vector<vector<int>>& counts);
+    Point fallbackShot();
+
+    int m_rows;
+    int m_cols;
+    int m_samplesPerMove;
+    vector<const PlacementTable*> m_tables; // by shipId
+    vector<int> m_alive;                    // shipIds not yet sunk, longest first
+    Bitboard m_miss;
+    Bitboard m_hits;                        // hits on ships not yet sunk
+    Bitboard m_sunk;
+    Bitboard m_shot;
+    long m_moves;
+    OpeningCursor m_opening;                // until the first hit
+    TablebaseProbe m_tablebase;
+    unique_ptr<WorkStealingPool> m_pool;
+};
+
+MonteCarloPlayer::MonteCarloPlayer(string nm, const Game& g, int samplesPerMove, int threads)
+ : Player(nm, g), m_rows(g.rows()), m_cols(g.cols()),
+   m_samplesPerMove(samplesPerMove < 1 ? 1 : samplesPerMove), m_moves(0), m_opening(g),
+   m_tablebase(g)
+{
+    for (int s = 0; s < g.nShips(); s++)
+    {
+        m_tables.push_back(&placementTable(m_rows, m_cols, g.shipLength(s)));
+        m_alive.push_back(s);
+    }
+    stable_sort(m_alive.begin(), m_alive.end(), [&g](int a, int b) {
+        return g.shipLength(a) > g.shipLength(b);
+    });
+    if (threads > 1)
+        m_pool.reset(new WorkStealingPool(threads));
+}
+
+bool MonteCarloPlayer::placeShips(Board& b)
+{
+    FleetGenerator gen(game());
+    return gen.placeFleet(b, rng());
+}
+
+  // Build one layout of the ships still afloat; return false if this
+  // attempt painted itself into a corner
+bool MonteCarloPlayer::sampleLayout(RandomStream& rs, Bitboard& layout) const
+{
+    Bitboard forbidden = m_miss | m_sunk;
+    Bitboard uncovered = m_hits;
+    int nAlive = m_alive.size();
+    int order[BITBOARD_CELLS];
+    copy(m_alive.begin(), m_alive.end(), order);
+    int nPlaced = 0;
+
+      // Cover each unsunk hit with a random (ship, placement) through it
+    while (uncovered.any())
+    {
+        int cell = uncovered.lowest();
+        int chosenSlot = -1;
+        Bitboard chosen;
+        int seen = 0;
+        for (int slot = nPlaced; slot < nAlive; slot++)
+        {
+            const PlacementTable& table = *m_tables[order[slot]];
+            for (const int* it = table.coverBegin(cell); it != table.coverEnd(cell); ++it)
+            {
+                const Bitboard& pl = table.mask(*it);
+                if ((pl & forbidden).none() && pl.andNot(m_hits).any() &&
+                    rs.below(++seen) == 0)
+                {
+                    chosenSlot = slot;
+                    chosen = pl;
+                }
+            }
+        }
+        if (chosenSlot < 0)
+            return false;
+        swap(order[nPlaced], order[chosenSlot]);
+        nPlaced++;
+        forbidden |= chosen;
+        uncovered = uncovered.andNot(chosen);
+    }
+
+      // Drop the rest anywhere free, trying random placements first and
+      // falling back to a scan when the board is crowded
+    for (int slot = nPlaced; slot < nAlive; slot++)
+    {
+        const PlacementTable& table = *m_tables[order[slot]];
+        bool done = false;
+        for (int tries = 0; tries < 8 && !done; tries++)
+        {
+            const Bitboard& pl = table.mask(rs.below(table.size()));
+            if ((pl & (forbidden | m_hits)).none())
+            {
+                forbidden |= pl;
+                done = true;
+            }
+        }
+        if (!done)
+        {
+            int seen = 0;
+            int pick = -1;
+            for (int i = 0; i < table.size(); i++)
+                if ((table.mask(i) & (forbidden | m_hits)).none() && rs.below(++seen) == 0)
+                    pick = i;
+            if (pick < 0)
+                return false;
+            forbidden |= table.mask(pick);
+        }
+    }
+    layout = forbidden.andNot(m_miss | m_sunk);
+    return true;
+}
+
+  // Sample the layouts of one chunk, stopping at the move's samples-th layout
+void MonteCarloPlayer::sampleChunk(const RandomStream& base, long chunk, long samples,
+                                   vector<int>& counts) const
+{
+    RandomStream rs = base.substream(chunk);
+    long begin = chunk * CHUNK;
+    long end = min<long>(begin + CHUNK, samples);
+    for (long k = begin; k < end; k++)
+    {
+        Bitboard layout;
+        if (!sampleLayout(rs, layout))
+            continue;
+        for (Bitboard b = layout.andNot(m_shot); b.any(); b.reset(b.lowest()))
+            counts[b.lowest()]++;
+        counts[BITBOARD_CELLS]++;
+    }
+}
+
+Point MonteCarloPlayer::recommendAttack()
+{
+      // A solved position beats both the opening line and sampling
+    int solved = m_tablebase.bestShot();
+    if (solved >= 0 && !m_shot.test(solved))
+        return Point(solved / m_cols, solved % m_cols);
+      // Until the first hit, the opening line replaces sampling
+    for (int cell = m_opening.next(); cell >= 0; cell = m_opening.next())
+        if (!m_shot.test(cell))
+            return Point(cell / m_cols, cell % m_cols);
+    RandomStream base = rng().substream(m_moves++);
+    int nWorkers = m_pool ? m_pool->size() : 1;
+      // counts[BITBOARD_CELLS] holds the number of layouts accepted
+    vector<vector<int>> counts(nWorkers, vector<int>(BITBOARD_CELLS + 1, 0));
+    if (!deadline().isSet())
+        sampleChunks(base, 0, (m_samplesPerMove + CHUNK - 1) / CHUNK, m_samplesPerMove, counts);
+    else
+    {
+          // Anytime: keep adding a round of one chunk per worker while two
+          // rounds like the last one would fit before the deadline, leaving
+          // room for a slow round and for picking the cell.  The choice then
+          // depends on timing, so it is no longer reproducible.
+        long chunk = 0;
+        Timer round;
+        do
+        {
+            round.start();
+            sampleChunks(base, chunk, chunk + nWorkers, LONG_MAX, counts);
+            chunk += nWorkers;
+        } while (deadline().remaining() > 2 * round.elapsed());
+    }
+    for (int w = 1; w < nWorkers; w++)
+        for (int cell = 0; cell <= BITBOARD_CELLS; cell++)
+            counts[0][cell] += counts[w][cell];
+    if (counts[0][BITBOARD_CELLS] == 0)
+        return fallbackShot();
+
+    int nCells = m_rows * m_cols;
+    int best = -1;
+    int bestCell = 0;
+    int ties = 0;
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        if (m_shot.test(cell))
+            continue;
+        if (counts[0][cell] > best)
+        {
+            best = counts[0][cell];
+            bestCell = cell;
+            ties = 1;
+        }
+        else if (counts[0][cell] == best && rng().below(++ties) == 0)
+            bestCell = cell;
+    }
+    return Point(bestCell / m_cols, bestCell % m_cols);
+}
+
+void MonteCarloPlayer::sampleChunks(const RandomStream& base, long first, long last, long samples,
+                                    vector<vector<int>>& counts)
+{
+    if (m_pool)
+    {
+        m_pool->parallelFor(last - first, 1, [&](int w, long begin, long end) {
+            for (long chunk = first + begin; chunk < first + end; chunk++)
+                sampleChunk(base, chunk, samples, counts[w]);
+        });
+    }
+    else
+    {
+        for (long chunk = first; chunk < last; chunk++)
+            sampleChunk(base, chunk, samples, counts[0]);
+    }
+}
+
+  // No layout could be sampled: try next to an unsunk hit, else anywhere new
+Point MonteCarloPlayer::fallbackShot()
+{
+    for (Bitboard h = m_hits; h.any(); h.reset(h.lowest()))
+    {
+        int r = h.lowest() / m_cols;
+        int c = h.lowest() % m_cols;
+        Point around[4] = { Point(r - 1, c), Point(r + 1, c), Point(r, c - 1), Point(r, c + 1) };
+        for (int k = 0; k < 4; k++)
+            if (game().isValid(around[k]) && !m_shot.test(around[k].r * m_cols + around[k].c))
+                return around[k];
+    }
+    int nCells = m_rows * m_cols;
+    int cell = rng().below(nCells);
+    while (m_shot.test(cell))
+        cell = (cell + 1) % nCells;
+    return Point(cell / m_cols, cell % m_cols);
+}
+
+void MonteCarloPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                          bool shipDestroyed, int shipId)
+{
+    if (!validShot || !game().isValid(p))
+        return;
+    int cell = p.r * m_cols + p.c;
+    if (!m_shot.test(cell))
+        m_tablebase.record(p, shotHit, shipDestroyed, shipId);
+    m_shot.set(cell);
+    if (!shotHit)
+    {
+        m_miss.set(cell);
+        return;
+    }
+    m_opening.stop();
+    m_hits.set(cell);
+    if (!shipDestroyed)
+        return;
+
+      // Retire the ship, and the run of hits it must have occupied
+    vector<int>::iterator it = find(m_alive.begin(), m_alive.end(), shipId);
+    if (it != m_alive.end())
+        m_alive.erase(it);
+    Bitboard where = Bitboard::cell(cell);
+    const PlacementTable& table = *m_tables[shipId];
+    for (const int* it = table.coverBegin(cell); it != table.coverEnd(cell); ++it)
+    {
+        const Bitboard& pl = table.mask(*it);
+        if (pl.andNot(m_hits).none())
+        {
+            where = pl;
+            break;
+        }
+    }
+    m_hits = m_hits.andNot(where);
+    m_sunk |= where;
+}
+
+Player* createMonteCarloPlayer(string nm, const Game& g, int samplesPerMove, int threads)
+{
+    if (g.rows() * g.cols() > BITBOARD_CELLS)
+        return createDensityPlayer(nm, g);
+    return new MonteCarloPlayer(nm, g, samplesPerMove, threads);
+}
@@ -0,0 +1,254 @@
+#include "OpeningBook.h"
+#include "Game.h"
+#include "FleetGenerator.h"
+#include "Random.h"
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+      // The stream every line is computed from
+    const uint64_t OPENING_SEED = 0x6f70656e696e6773ULL;
+      // Below this many layouts consistent with the misses so far, the
+      // ranking of cells is mostly noise, so the line ends
+    const int MIN_SAMPLES = 50;
+
+    string boardKey(int rows, int cols)
+    {
+        return to_string(rows) + "x" + to_string(cols);
+    }
+
+    string shipsKey(const Game& g)
+    {
+        string key;
+        for (int s = 0; s < g.nShips(); s++)
+        {
+            if (s > 0)
+                key += ' ';
+            key += to_string(g.shipLength(s));
+        }
+        return key;
+    }
+
+    string configKey(const Game& g)
+    {
+        return boardKey(g.rows(), g.cols()) + "," + shipsKey(g);
+    }
+
+      // Parse "RxC,lengths,cells" into the key and line; false if malformed,
+      // including a line longer than OPENING_SHOTS or one that repeats a cell
+    bool parseLine(const string& text, string& key, vector<int>& line)
+    {
+        size_t comma1 = text.find(',');
+        size_t comma2 = (comma1 == string::npos ? comma1 : text.find(',', comma1 + 1));
+        if (comma2 == string::npos)
+            return false;
+        int rows, cols;
+        char x;
+        istringstream board(text.substr(0, comma1));
+        if (!(board >> rows >> x >> cols) || x != 'x' || rows < 1 || cols < 1)
+            return false;
+        istringstream ships(text.substr(comma1 + 1, comma2 - comma1 - 1));
+        string lengths;
+        int len;
+        while (ships >> len)
+        {
+            if (len < 1)
+                return false;
+            lengths += (lengths.empty() ? "" : " ") + to_string(len);
+        }
+        if (lengths.empty() || !ships.eof())
+            return false;
+        istringstream shots(text.substr(comma2 + 1));
+        line.clear();
+        int cell;
+        while (shots >> cell)
+        {
+            if (cell < 0 || cell >= rows * cols || int(line.size()) == OPENING_SHOTS ||
+                find(line.begin(), line.end(), cell) != line.end())
+                return false;
+            line.push_back(cell);
+        }
+        if (!shots.eof())
+            return false;
+        key = boardKey(rows, cols) + "," + lengths;
+        return true;
+    }
+
+    mutex bookMutex;
+    OpeningBook& processBook()
+    {
+        static OpeningBook book;
+        return book;
+    }
+}
+
+vector<int> computeOpening(const Game& g, int samples)
+{
+    vector<int> line;
+    int cols = g.cols();
+    int nCells = g.rows() * cols;
+    int segments = 0;
+    for (int s = 0; s < g.nShips(); s++)
+        segments += g.shipLength(s);
+    if (segments == 0)
+        return line;
+
+      // The cells of every sampled layout, segments to a layout
+    FleetGenerator gen(g);
+    RandomStream rs(OPENING_SEED, 0, GAME_STREAM);
+    vector<ShipPlacement> layout;
+    vector<int> cells;
+    cells.reserve(size_t(samples) * segments);
+    for (int k = 0; k < samples; k++)
+    {
+        if (!gen.generate(rs, layout))
+            return line;
+        for (int s = 0; s < g.nShips(); s++)
+        {
+            int start = layout[s].topOrLeft.r * cols + layout[s].topOrLeft.c;
+            int step = (layout[s].dir == HORIZONTAL ? 1 : cols);
+            for (int i = 0; i < g.shipLength(s); i++)
+                cells.push_back(start + i * step);
+        }
+    }
+
+    int left = samples;
+    vector<int> counts(nCells);
+    while (int(line.size()) < OPENING_SHOTS && left >= MIN_SAMPLES)
+    {
+        fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < size_t(left) * segments; i++)
+            counts[cells[i]]++;
+          // No layout left covers a cell already in the line, so it can't
+          // be chosen again
+        int best = int(max_element(counts.begin(), counts.end()) - counts.begin());
+        if (counts[best] == 0)
+            break;
+        line.push_back(best);
+          // Keep the layouts that this shot misses
+        int kept = 0;
+        for (int k = 0; k < left; k++)
+        {
+            const int* layoutCells = &cells[size_t(k) * segments];
+            if (find(layoutCells, layoutCells + segments, best) != layoutCells + segments)
+                continue;
+            if (kept != k)
+                copy(layoutCells, layoutCells + segments, &cells[size_t(kept) * segments]);
+            kept++;
+        }
+        left = kept;
+    }
+    return line;
+}
+
+//******************** OpeningBook functions *************************
+
+const vector<int>* OpeningBook::find(const Game& g) const
+{
+    map<string, vector<int>>::const_iterator it = m_lines.find(configKey(g));
+    return it == m_lines.end() ? nullptr : &it->second;
+}
+
+void OpeningBook::add(const Game& g, const vector<int>& line)
+{
+    m_lines[configKey(g)] = line;
+}
+
+bool OpeningBook::load(const string& path)
+{
+    ifstream in(path);
+    string text;
+    if (!in || !getline(in, text) || text != "board,ships,shots")
+        return false;
+    map<string, vector<int>> lines;
+    while (getline(in, text))
+    {
+        if (text.empty())
+            continue;
+        string key;
+        vector<int> line;
+        if (!parseLine(text, key, line))
+            return false;
+        lines[key] = line;
+    }
+    for (map<string, vector<int>>::iterator it = lines.begin(); it != lines.end(); ++it)
+        m_lines.insert(*it);
+    return true;
+}
+
+bool OpeningBook::save(const string& path) const
+{
+    ofstream out(path);
+    out << "board,ships,shots\n";
+    for (map<string, vector<int>>::const_iterator it = m_lines.begin(); it != m_lines.end(); ++it)
+    {
+        out << it->first << ',';
+        for (size_t k = 0; k < it->second.size(); k++)
+            out << (k > 0 ? " " : "") << it->second[k];
+        out << '\n';
+    }
+    return bool(out);
+}
+
+//******************** Process-wide book *****************************
+
+  // Every player asks for its line when it is made, two per game, so each
+  // thread keeps the lines it has been given and finds them again without
+  // the lock or a key string.  That is safe because lines are never
+  // replaced or removed from the book.
+const vector<int>& openingLine(const Game& g)
+{
+    struct Seen
+    {
+        int rows;
+        int cols;
+        vector<int> lengths;
+        const vector<int>* line;
+    };
+    thread_local vector<Seen> seen;
+    for (const Seen& s : seen)
+    {
+        if (s.rows != g.rows() || s.cols != g.cols() || int(s.lengths.size()) != g.nShips())
+            continue;
+        int k = 0;
+        while (k < g.nShips() && s.lengths[k] == g.shipLength(k))
+            k++;
+        if (k == g.nShips())
+            return *s.line;
+    }
+
+    Seen s;
+    s.rows = g.rows();
+    s.cols = g.cols();
+    for (int k = 0; k < g.nShips(); k++)
+        s.lengths.push_back(g.shipLength(k));
+    {
+        lock_guard<mutex> lock(bookMutex);
+        OpeningBook& book = processBook();
+        s.line = book.find(g);
+        if (s.line == nullptr)
+        {
+            book.add(g, computeOpening(g));
+            s.line = book.find(g);
+        }
+    }
+    seen.push_back(s);
+    return *s.line;
+}
+
+bool loadOpeningBook(const string& path)
+{
+    lock_guard<mutex> lock(bookMutex);
+    return processBook().load(path);
+}
+
+bool saveOpeningBook(const string& path)
+{
+    lock_guard<mutex> lock(bookMutex);
+    return processBook().save(path);
+}
@@ -0,0 +1,73 @@
+#ifndef OPENINGBOOK_INCLUDED
+#define OPENINGBOOK_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+class Game;
+
+  // The longest opening line kept for a configuration
+const int OPENING_SHOTS = 20;
+  // Random layouts drawn to compute a line
+const int OPENING_SAMPLES = 50000;
+
+  // The opening line for a game's configuration: the cells (row * cols +
+  // col) to fire at, in order, against a fleet laid out by FleetGenerator
+  // while every shot so far has missed.  Each shot is the cell that the
+  // most of the sampled layouts consistent with those misses cover.  The
+  // samples come from a fixed stream, so the same configuration always
+  // gets the same line.  The line stops early when too few samples are
+  // left to rank the cells, and is empty if no layout exists.
+std::vector<int> computeOpening(const Game& g, int samples = OPENING_SAMPLES);
+
+  // Opening lines keyed by board size and the lengths of the ships, in the
+  // order they were added.  A book file is CSV with a header line and one
+  // "board,ships,shots" line per configuration, e.g.
+  //     10x10,5 4 3 3 2,44 55 33 ...
+class OpeningBook
+{
+  public:
+      // The line for g's configuration, or nullptr if the book has none
+    const std::vector<int>* find(const Game& g) const;
+      // Add or replace the line for g's configuration
+    void add(const Game& g, const std::vector<int>& line);
+      // Add the lines in a book file, keeping any configuration already
+      // present; false if it can't be read or is malformed
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+  private:
+    std::map<std::string, std::vector<int>> m_lines;   // by "board,ships"
+};
+
+  // The line for g from the process-wide book, computed and added the first
+  // time a configuration is asked for.  Lines are never replaced, so the
+  // reference stays valid for the rest of the program.  Safe to call from
+  // any thread; only a thread's first call for a configuration locks.
+const std::vector<int>& openingLine(const Game& g);
+  // Add a book file's lines to the process-wide book.  Load it before any
+  // player of those configurations is created, since lines already in use
+  // are kept.
+bool loadOpeningBook(const std::string& path);
+bool saveOpeningBook(const std::string& path);
+
+  // A player's place in its game's opening line.  It hands out the line's
+  // cells in order, one array read each, until the line runs out or the
+  // player stops it at its first hit.
+class OpeningCursor
+{
+  public:
+    OpeningCursor(const Game& g) : m_line(&openingLine(g)), m_next(0) {}
+    bool active() const { return m_next < m_line->size(); }
+      // The next cell of the line, or -1 once it is used up or stopped
+    int next() { return active() ? (*m_line)[m_next++] : -1; }
+    void stop() { m_next = m_line->size(); }
+
+  private:
+    const std::vector<int>* m_line;
+    size_t m_next;
+};
+
+#endif // OPENINGBOOK_INCLUDED
@@ -0,0 +1,90 @@
+#include "Strategies.h"
+#include "Solver.h"
+#include "Tablebase.h"
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include "FleetGenerator.h"
+#include <string>
+
+using namespace std;
+
+//*********************************************************************
+//  OptimalPlayer
+//*********************************************************************
+
+// Plays the policy of the shared OptimalSolver for its configuration:
+// it keeps the layouts still consistent with what it has seen and fires
+// where the solver says the expected number of shots left is least.
+// Against an opponent whose layouts are all equally likely, no player
+// sinks the fleet in fewer shots on average.  When the shared tablebase
+// holds the configuration, the player reads the policy from it instead,
+// and the configuration is never solved in this process.
+
+class OptimalPlayer : public Player
+{
+  public:
+      // solver is null when the tablebase has the configuration
+    OptimalPlayer(string nm, const Game& g, OptimalSolver* solver)
+     : Player(nm, g), m_solver(solver), m_tablebase(g)
+    {
+        if (m_solver != nullptr)
+            m_solver->start(m_knowledge);
+    }
+    bool placeShips(Board& b)
+    {
+        FleetGenerator gen(game());
+        return gen.placeFleet(b, rng());
+    }
+    Point recommendAttack();
+    void recordAttackResult(Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    void recordAttackByOpponent(Point /* p */) {}
+
+  private:
+    OptimalSolver* m_solver;
+    OptimalSolver::Knowledge m_knowledge;
+    TablebaseProbe m_tablebase;
+    Bitboard m_shot;
+};
+
+Point OptimalPlayer::recommendAttack()
+{
+    int cell = m_tablebase.bestShot();
+    if (cell < 0 && m_solver != nullptr)
+        cell = m_solver->bestShot(m_knowledge);
+    if (cell >= 0 && !m_shot.test(cell))
+        return Point(cell / game().cols(), cell % game().cols());
+
+      // Only an opponent fleet that was never enumerated gets here; fire at
+      // any cell not yet tried
+    for (int c = 0; c < game().rows() * game().cols(); c++)
+    {
+        if (!m_shot.test(c))
+            return Point(c / game().cols(), c % game().cols());
+    }
+    return randomCell();
+}
+
+void OptimalPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                       bool shipDestroyed, int shipId)
+{
+    int cell = p.r * game().cols() + p.c;
+    if (!validShot || !game().isValid(p) || m_shot.test(cell))
+        return;
+    m_shot.set(cell);
+    m_tablebase.record(p, shotHit, shipDestroyed, shipId);
+    if (m_solver != nullptr)
+        m_solver->record(m_knowledge, cell, shotHit, shipDestroyed, shipId);
+}
+
+Player* createOptimalPlayer(string nm, const Game& g)
+{
+    if (sharedTablebase().findConfig(g) >= 0)
+        return new OptimalPlayer(nm, g, nullptr);
+    OptimalSolver* solver = optimalSolver(g);
+    if (solver == nullptr)
+        return createDensityPlayer(nm, g);
+    return new OptimalPlayer(nm, g, solver);
+}
@@ -0,0 +1,85 @@
+#include "PlacementTable.h"
+#include <map>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+      // The standard 10x10 game's tables, evaluated by the compiler
+    constexpr FixedPlacements<10, 10, 2> standard2;
+    constexpr FixedPlacements<10, 10, 3> standard3;
+    constexpr FixedPlacements<10, 10, 4> standard4;
+    constexpr FixedPlacements<10, 10, 5> standard5;
+    static_assert(FixedPlacements<10, 10, 5>::N == 120, "10x10 has 120 five-cell placements");
+    static_assert(standard2.coverBegin[100] == 2 * 180, "every placement covers two cells");
+
+    template <int R, int C, int L>
+    PlacementTable view(const FixedPlacements<R, C, L>& f)
+    {
+        return PlacementTable(R, C, L, f.mask, f.coverBegin, f.cover);
+    }
+
+    struct BuiltTable
+    {
+        vector<Bitboard> masks;
+        vector<int> coverBegin;
+        vector<int> cover;
+        unique_ptr<PlacementTable> table;
+    };
+
+    BuiltTable* buildTable(int rows, int cols, int length)
+    {
+        BuiltTable* t = new BuiltTable;
+        int n = placementCount(rows, cols, length);
+        int nCells = rows * cols;
+        bool fits = (nCells <= BITBOARD_CELLS);
+        vector<int> count(nCells, 0);
+        for (int i = 0; i < n; i++)
+        {
+            int start = placementStart(rows, cols, length, i);
+            int step = placementStep(rows, cols, length, i);
+            if (fits)
+                t->masks.push_back(Bitboard::line(start, length, step));
+            for (int k = 0; k < length; k++)
+                count[start + k * step]++;
+        }
+        t->coverBegin.assign(nCells + 1, 0);
+        for (int cell = 0; cell < nCells; cell++)
+            t->coverBegin[cell + 1] = t->coverBegin[cell] + count[cell];
+        t->cover.resize(t->coverBegin[nCells]);
+        for (int cell = 0; cell < nCells; cell++)
+            count[cell] = t->coverBegin[cell];
+        for (int i = 0; i < n; i++)
+        {
+            int start = placementStart(rows, cols, length, i);
+            int step = placementStep(rows, cols, length, i);
+            for (int k = 0; k < length; k++)
+                t->cover[count[start + k * step]++] = i;
+        }
+        t->table.reset(new PlacementTable(rows, cols, length,
+                                          fits ? t->masks.data() : nullptr,
+                                          t->coverBegin.data(), t->cover.data()));
+        return t;
+    }
+}
+
+const PlacementTable& placementTable(int rows, int cols, int length)
+{
+    static const PlacementTable standard[4] = {
+        view(standard2), view(standard3), view(standard4), view(standard5)
+    };
+    if (rows == 10 && cols == 10 && length >= 2 && length <= 5)
+        return standard[length - 2];
+
+    static mutex m;
+    static map<tuple<int, int, int>, unique_ptr<BuiltTable>> built;
+    lock_guard<mutex> lock(m);
+    unique_ptr<BuiltTable>& t = built[make_tuple(rows, cols, length)];
+    if (!t)
+        t.reset(buildTable(rows, cols, length));
+    return *t->table;
+}
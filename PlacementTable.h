@@ -0,0 +1,130 @@
+#ifndef PLACEMENTTABLE_INCLUDED
+#define PLACEMENTTABLE_INCLUDED
+
+#include "globals.h"
+#include "Bitboard.h"
+
+// The placements of a ship of length L on an R x C board are numbered with
+// the horizontal ones first, row by row, then the vertical ones, row by
+// row.  A placement is described by its first cell and the step between its
+// cells (1 across, C down).  A ship of length 1 has only horizontal
+// placements, so no cell is counted twice.
+
+constexpr int horizontalPlacements(int R, int C, int L)
+{
+    return L <= C ? R * (C - L + 1) : 0;
+}
+
+constexpr int verticalPlacements(int R, int C, int L)
+{
+    return (L > 1 && L <= R) ? (R - L + 1) * C : 0;
+}
+
+constexpr int placementCount(int R, int C, int L)
+{
+    return horizontalPlacements(R, C, L) + verticalPlacements(R, C, L);
+}
+
+constexpr int placementStart(int R, int C, int L, int i)
+{
+    int nH = horizontalPlacements(R, C, L);
+    return i < nH ? (i / (C - L + 1)) * C + i % (C - L + 1) : i - nH;
+}
+
+constexpr int placementStep(int R, int C, int L, int i)
+{
+    return i < horizontalPlacements(R, C, L) ? 1 : C;
+}
+
+  // The number of the placement with the given top or left cell, or -1 if
+  // the ship would run off the board
+constexpr int placementIndex(int R, int C, int L, int r, int c, Direction dir)
+{
+    if (r < 0 || r >= R || c < 0 || c >= C)
+        return -1;
+    if (dir == HORIZONTAL)
+        return c + L <= C ? r * (C - L + 1) + c : -1;
+    if (L == 1)
+        return r * C + c;
+    return r + L <= R ? horizontalPlacements(R, C, L) + r * C + c : -1;
+}
+
+  // The placement masks of one board shape and ship length, together with,
+  // for every cell, the numbers of the placements covering it, all built at
+  // compile time.  The board must fit in a Bitboard.
+template <int R, int C, int L>
+struct FixedPlacements
+{
+    static_assert(R * C <= BITBOARD_CELLS, "board does not fit in a Bitboard");
+    static constexpr int N = placementCount(R, C, L);
+    static constexpr int SLOTS = (N > 0 ? N : 1);
+
+    constexpr FixedPlacements() : mask(), coverBegin(), cover()
+    {
+        int count[R * C + 1] = {};
+        for (int i = 0; i < N; i++)
+        {
+            mask[i] = Bitboard::line(placementStart(R, C, L, i), L, placementStep(R, C, L, i));
+            for (int k = 0; k < L; k++)
+                count[placementStart(R, C, L, i) + k * placementStep(R, C, L, i)]++;
+        }
+        for (int cell = 0; cell < R * C; cell++)
+            coverBegin[cell + 1] = coverBegin[cell] + count[cell];
+        for (int cell = 0; cell < R * C; cell++)
+            count[cell] = coverBegin[cell];
+        for (int i = 0; i < N; i++)
+            for (int k = 0; k < L; k++)
+                cover[count[placementStart(R, C, L, i) + k * placementStep(R, C, L, i)]++] = i;
+    }
+
+    Bitboard mask[SLOTS];
+    int coverBegin[R * C + 1];
+    int cover[SLOTS * L];
+};
+
+  // A read-only view of the placements of one board shape and ship length.
+  // The views returned by placementTable live for the rest of the program,
+  // so boards and players look theirs up once and keep the pointer.
+class PlacementTable
+{
+  public:
+    PlacementTable(int rows, int cols, int length, const Bitboard* masks,
+                   const int* coverBegin, const int* cover)
+     : m_rows(rows), m_cols(cols), m_length(length),
+       m_size(placementCount(rows, cols, length)), m_masks(masks),
+       m_coverBegin(coverBegin), m_cover(cover)
+    {}
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int length() const { return m_length; }
+    int size() const { return m_size; }
+    int start(int i) const { return placementStart(m_rows, m_cols, m_length, i); }
+    int step(int i) const { return placementStep(m_rows, m_cols, m_length, i); }
+    int index(Point topOrLeft, Direction dir) const
+    {
+        return placementIndex(m_rows, m_cols, m_length, topOrLeft.r, topOrLeft.c, dir);
+    }
+      // Masks exist only for boards that fit in a Bitboard
+    bool hasMasks() const { return m_masks != nullptr; }
+    const Bitboard& mask(int i) const { return m_masks[i]; }
+      // The placements covering a cell are [coverBegin(cell), coverEnd(cell))
+    const int* coverBegin(int cell) const { return m_cover + m_coverBegin[cell]; }
+    const int* coverEnd(int cell) const { return m_cover + m_coverBegin[cell + 1]; }
+
+  private:
+    int m_rows;
+    int m_cols;
+    int m_length;
+    int m_size;
+    const Bitboard* m_masks;
+    const int* m_coverBegin;
+    const int* m_cover;
+};
+
+  // The table for a board shape and ship length.  The 10x10 tables for the
+  // standard fleet's lengths are compile-time constants; any other table is
+  // built the first time it is asked for.  Safe to call from any thread.
+const PlacementTable& placementTable(int rows, int cols, int length);
+
+#endif // PLACEMENTTABLE_INCLUDED
@@ -2,6 +2,8 @@
 #define PLAYER_INCLUDED
 
 #include <string>
+#include "Random.h"
+#include "Timer.h"
 
 class Point;
 class Board;
@@ -18,6 +20,11 @@ class Player
 
     std::string name() const { return m_name; }
     const Game& game() const { return m_game; }
+      // Game::simulate hands each seat its own stream before ships are placed
+    void setRandomStream(const RandomStream& rs) { m_rng = rs; }
+      // When the game has a time budget it sets the deadline for each move
+      // before asking for it; an anytime player works until the deadline
+    void setDeadline(const Deadline& d) { m_deadline = d; }
 
     virtual bool isHuman() const { return false; }
 
@@ -30,9 +37,16 @@ class Player
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
 
+  protected:
+    RandomStream& rng() { return m_rng; }
+    const Deadline& deadline() const { return m_deadline; }
+    Point randomCell();
+
   private:
     std::string m_name;
     const Game& m_game;
+    RandomStream m_rng;
+    Deadline m_deadline;
 };
 
 Player* createPlayer(std::string type, std::string nm, const Game& g);
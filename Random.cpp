@@ -0,0 +1,12 @@
+#include "Random.h"
+#include <random>
+
+uint64_t entropySeed()
+{
+    static thread_local uint64_t base = [] {
+        std::random_device rd;
+        return (uint64_t(rd()) << 32) ^ rd();
+    }();
+    static thread_local uint64_t counter = 0;
+    return mix64(base + ++counter);
+}
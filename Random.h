@@ -0,0 +1,78 @@
+#ifndef RANDOM_INCLUDED
+#define RANDOM_INCLUDED
+
+#include <cstdint>
+
+  // The independent streams each game draws from.  A stream is identified
+  // by (seed, game index, stream id), so a game replays bit for bit from its
+  // seed and index no matter which thread plays it or what ran before.
+enum RandomStreamId {
+    GAME_STREAM, BOARD1_STREAM, BOARD2_STREAM, PLAYER1_STREAM, PLAYER2_STREAM
+};
+
+  // SplitMix64's finalizer: a bijective mix of all 64 input bits
+inline uint64_t mix64(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+  // A seed that differs on every call, for code that doesn't ask for
+  // reproducibility.  Only the first call on each thread touches
+  // std::random_device.
+uint64_t entropySeed();
+
+  // A counter-based generator: draw n of a stream is mix64 of the stream's
+  // key plus n times a fixed odd constant, so the whole state is two words,
+  // copying a stream is free and no two streams share anything.
+class RandomStream
+{
+  public:
+    RandomStream() : m_key(mix64(entropySeed())), m_counter(0) {}
+    RandomStream(uint64_t seed, uint64_t gameIndex, uint64_t streamId)
+     : m_key(mix64(mix64(mix64(seed) + gameIndex) + streamId)), m_counter(0)
+    {}
+
+      // A stream keyed by this one and sub, e.g. one per worker or per move
+    RandomStream substream(uint64_t sub) const
+    {
+        RandomStream s;
+        s.m_key = mix64(m_key ^ mix64(sub + 0x632be59bd9b4e019ULL));
+        s.m_counter = 0;
+        return s;
+    }
+
+    uint64_t next()
+    {
+        return mix64(m_key + 0x9e3779b97f4a7c15ULL * ++m_counter);
+    }
+
+      // Return a uniformly distributed int from 0 to limit-1 using Lemire's
+      // multiply-and-shift; the rejection branch is taken with probability
+      // below limit/2^32, so almost every call is one draw and one multiply.
+    int below(int limit)
+    {
+        if (limit <= 1)
+            return 0;
+        uint32_t range = uint32_t(limit);
+        uint64_t m = uint64_t(uint32_t(next() >> 32)) * range;
+        uint32_t low = uint32_t(m);
+        if (low < range)
+        {
+            uint32_t threshold = uint32_t(-range) % range;
+            while (low < threshold)
+            {
+                m = uint64_t(uint32_t(next() >> 32)) * range;
+                low = uint32_t(m);
+            }
+        }
+        return int(m >> 32);
+    }
+
+  private:
+    uint64_t m_key;
+    uint64_t m_counter;
+};
+
+#endif // RANDOM_INCLUDED
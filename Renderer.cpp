@@ -0,0 +1,161 @@
+#include "Renderer.h"
+#include "Board.h"
+#include <ostream>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+      // Unchanged characters worth rewriting to save a cursor move
+    const int MAX_GAP = 4;
+
+    void splitLines(const string& text, vector<string>& lines)
+    {
+        lines.clear();
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find('\n', start);
+            if (end == string::npos)
+                end = text.size();
+            lines.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+
+    void moveTo(string& out, int row, int col)
+    {
+        out += "\x1b[";
+        out += to_string(row + 1);
+        out += ';';
+        out += to_string(col + 1);
+        out += 'H';
+    }
+}
+
+FrameRenderer::FrameRenderer(ostream& out, bool ansi)
+ : m_out(out), m_ansi(ansi), m_valid(false)
+{}
+
+void FrameRenderer::clear()
+{
+    m_frame.clear();
+}
+
+void FrameRenderer::addText(const string& text)
+{
+    m_frame += text;
+    if (!text.empty() && text.back() != '\n')
+        m_frame += '\n';
+}
+
+void FrameRenderer::addBoard(const Board& b, bool shotsOnly)
+{
+    b.render(shotsOnly, m_frame);
+}
+
+void FrameRenderer::addSideBySide(const string& left, const string& right, int gap)
+{
+    vector<string> l, r;
+    splitLines(left, l);
+    splitLines(right, r);
+    size_t width = 0;
+    for (const string& line : l)
+        width = max(width, line.size());
+    for (size_t k = 0; k < max(l.size(), r.size()); k++)
+    {
+        if (k < r.size() && !r[k].empty())
+        {
+            const string& line = (k < l.size() ? l[k] : string());
+            m_frame += line;
+            m_frame.append(width - line.size() + gap, ' ');
+            m_frame += r[k];
+        }
+        else if (k < l.size())
+            m_frame += l[k];
+        m_frame += '\n';
+    }
+}
+
+void FrameRenderer::addBoards(const string& leftTitle, const Board& left, bool leftShotsOnly,
+                              const string& rightTitle, const Board& right, bool rightShotsOnly)
+{
+    string l = leftTitle + '\n';
+    string r = rightTitle + '\n';
+    left.render(leftShotsOnly, l);
+    right.render(rightShotsOnly, r);
+    addSideBySide(l, r);
+}
+
+void FrameRenderer::present()
+{
+    if (!m_ansi)
+    {
+        m_out.write(m_frame.data(), m_frame.size());
+        m_out.flush();
+        return;
+    }
+    vector<string> lines;
+    splitLines(m_frame, lines);
+    string out;
+    if (!m_valid)
+    {
+          // Home the cursor and clear the screen, then draw everything
+        out = "\x1b[H\x1b[2J";
+        out += m_frame;
+        if (!m_frame.empty() && m_frame.back() != '\n')
+            out += '\n';
+    }
+    else
+        update(lines, out);
+      // Leave the cursor below the frame, erasing any prompts and answers
+      // written there since the last frame
+    moveTo(out, int(lines.size()), 0);
+    out += "\x1b[J";
+    m_out.write(out.data(), out.size());
+    m_out.flush();
+    m_shown.swap(lines);
+    m_valid = true;
+}
+
+void FrameRenderer::invalidate()
+{
+    m_valid = false;
+}
+
+  // Append to out the cursor moves and text that turn the frame on screen
+  // into lines
+void FrameRenderer::update(const vector<string>& lines, string& out) const
+{
+    static const string none;
+    for (size_t row = 0; row < lines.size(); row++)
+    {
+        const string& now = lines[row];
+        const string& was = (row < m_shown.size() ? m_shown[row] : none);
+        if (now == was)
+            continue;
+        size_t col = 0;
+        while (col < now.size())
+        {
+            if (col < was.size() && now[col] == was[col])
+            {
+                col++;
+                continue;
+            }
+              // A run of changes, bridging short stretches of unchanged text
+            size_t end = col + 1;
+            for (size_t k = end; k < now.size() && k < end + MAX_GAP; k++)
+                if (k >= was.size() || now[k] != was[k])
+                    end = k + 1;
+            moveTo(out, int(row), int(col));
+            out.append(now, col, end - col);
+            col = end;
+        }
+        if (was.size() > now.size())
+        {
+            moveTo(out, int(row), int(now.size()));
+            out += "\x1b[K";
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef RENDERER_INCLUDED
+#define RENDERER_INCLUDED
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+class Board;
+
+  // Builds a screenful of text in memory and writes it in one go.  In
+  // plain mode present() writes the frame as it stands.  In ANSI mode the
+  // renderer owns the top of the terminal: the first frame clears the
+  // screen, and later frames move the cursor to rewrite only the runs of
+  // characters that changed since the last frame, then leave the cursor
+  // on the line below the frame with everything under it erased.
+class FrameRenderer
+{
+  public:
+    FrameRenderer(std::ostream& out, bool ansi);
+    bool ansi() const { return m_ansi; }
+      // Start a new frame
+    void clear();
+      // Append text; a missing final newline is supplied
+    void addText(const std::string& text);
+    void addBoard(const Board& b, bool shotsOnly);
+      // Append two blocks of text next to each other, gap spaces apart
+    void addSideBySide(const std::string& left, const std::string& right, int gap = 4);
+    void addBoards(const std::string& leftTitle, const Board& left, bool leftShotsOnly,
+                   const std::string& rightTitle, const Board& right, bool rightShotsOnly);
+    void present();
+      // Make the next present() redraw the whole screen, e.g. after other
+      // output scrolled it
+    void invalidate();
+
+  private:
+    void update(const std::vector<std::string>& lines, std::string& out) const;
+
+    std::ostream& m_out;
+    bool m_ansi;
+    std::string m_frame;                  // the frame being built
+    std::vector<std::string> m_shown;     // the frame on screen, in ANSI mode
+    bool m_valid;                         // m_shown matches the screen
+};
+
+#endif // RENDERER_INCLUDED
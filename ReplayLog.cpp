@@ -0,0 +1,369 @@
+#include "ReplayLog.h"
+#include "Game.h"
+#include "Board.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'S', 'R', 'B' };
+    const uint64_t VERSION = 2;
+      // Version 1 records lack the seed and game index
+    const uint64_t FIRST_VERSION = 1;
+    const int INDEX_ENTRY_BYTES = 20;
+
+    enum ShotCode { SHOT_MISS, SHOT_HIT, SHOT_SUNK, SHOT_INVALID };
+
+    void putVarint(string& out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out += char(v | 0x80);
+            v >>= 7;
+        }
+        out += char(v);
+    }
+
+    bool getVarint(const string& in, size_t& pos, uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7)
+        {
+            unsigned char byte = in[pos++];
+            v |= uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void putFixed(string& out, uint64_t v, int bytes)
+    {
+        for (int k = 0; k < bytes; k++)
+            out += char(v >> (8 * k));
+    }
+
+    uint64_t getFixed(const char* in, int bytes)
+    {
+        uint64_t v = 0;
+        for (int k = 0; k < bytes; k++)
+            v |= uint64_t(static_cast<unsigned char>(in[k])) << (8 * k);
+        return v;
+    }
+
+    string indexPath(const string& path)
+    {
+        return path + ".idx";
+    }
+
+    uint64_t fileSize(const string& path)
+    {
+        ifstream in(path, ios::binary | ios::ate);
+        return in ? uint64_t(in.tellg()) : 0;
+    }
+}
+
+//******************** ReplayLog functions ***************************
+
+ReplayLog::ReplayLog(const Game& g, const string& path)
+ : m_path(path), m_ok(true), m_games(0), m_offset(fileSize(path)), m_blockGames(0)
+{
+    m_header.assign(MAGIC, sizeof(MAGIC));
+    putVarint(m_header, VERSION);
+    putVarint(m_header, g.rows());
+    putVarint(m_header, g.cols());
+    putVarint(m_header, g.nShips());
+    for (int s = 0; s < g.nShips(); s++)
+    {
+        putVarint(m_header, g.shipLength(s));
+        m_header += g.shipSymbol(s);
+        putVarint(m_header, g.shipName(s).size());
+        m_header += g.shipName(s);
+    }
+
+      // Continue the numbering of the games already in the log
+    ifstream idx(indexPath(path), ios::binary);
+    char entry[INDEX_ENTRY_BYTES];
+    while (idx.read(entry, INDEX_ENTRY_BYTES))
+        m_games = getFixed(entry, 8) + getFixed(entry + 16, 4);
+    ofstream touch(path, ios::binary | ios::app);
+    m_ok = bool(touch);
+}
+
+ReplayLog::~ReplayLog()
+{
+    flush();
+}
+
+long ReplayLog::games() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return long(m_games);
+}
+
+long ReplayLog::append(const string& record)
+{
+    lock_guard<mutex> lock(m_mutex);
+    putVarint(m_block, record.size());
+    m_block += record;
+    m_blockGames++;
+    long n = long(m_games++);
+    if (m_blockGames == GAMES_PER_BLOCK)
+        writeBlock();
+    return n;
+}
+
+void ReplayLog::flush()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_blockGames > 0)
+        writeBlock();
+}
+
+  // Write the buffered games as one block and index it; the caller holds
+  // the mutex
+void ReplayLog::writeBlock()
+{
+    string block = m_header;
+    putVarint(block, m_blockGames);
+    block += m_block;
+    ofstream out(m_path, ios::binary | ios::app);
+    out.write(block.data(), block.size());
+
+    string entry;
+    putFixed(entry, m_games - m_blockGames, 8);
+    putFixed(entry, m_offset, 8);
+    putFixed(entry, m_blockGames, 4);
+    ofstream idx(indexPath(m_path), ios::binary | ios::app);
+    idx.write(entry.data(), entry.size());
+    if (!out || !idx)
+        m_ok = false;
+
+    m_offset += block.size();
+    m_block.clear();
+    m_blockGames = 0;
+}
+
+//******************** ReplayRecorder functions **********************
+
+ReplayRecorder::ReplayRecorder(ReplayLog& log, const Game& g)
+ : m_log(log), m_game(g), m_rows(g.rows()), m_cols(g.cols())
+{}
+
+void ReplayRecorder::shipsPlaced(const Board& b1, const Board& b2)
+{
+    m_fleets.clear();
+    m_shots.clear();
+    m_nShots = 0;
+    m_lastShooter = 1;
+    for (const Board* b : { &b1, &b2 })
+    {
+        for (int s = 0; s < m_game.nShips(); s++)
+        {
+            Point p;
+            Direction dir = HORIZONTAL;
+            b->shipPlacement(s, p, dir);
+            putVarint(m_fleets, uint64_t(p.r * m_cols + p.c) << 1 | (dir == VERTICAL));
+        }
+    }
+}
+
+void ReplayRecorder::shotFired(const Player& /* attacker */, const ShotEvent& e,
+                               const Board& /* target */)
+{
+    ShotCode code = SHOT_INVALID;
+    if (e.validShot)
+        code = e.shipDestroyed ? SHOT_SUNK : (e.shotHit ? SHOT_HIT : SHOT_MISS);
+      // An invalid shot changes nothing, so a cell off the board is kept as 0
+    bool onBoard = (e.p.r >= 0 && e.p.r < m_rows && e.p.c >= 0 && e.p.c < m_cols);
+    uint64_t cell = onBoard ? uint64_t(e.p.r * m_cols + e.p.c) : 0;
+    putVarint(m_shots, cell << 2 | code);
+    m_nShots++;
+    m_lastShooter = e.shooter;
+}
+
+void ReplayRecorder::gameOver(const Player* /* winner */)
+{
+      // The game ends on the winner's shot
+    string record(1, char(m_lastShooter));
+    putVarint(record, m_game.seed());
+    putVarint(record, m_game.gameIndex());
+    record += m_fleets;
+    putVarint(record, m_nShots);
+    record += m_shots;
+    m_log.append(record);
+}
+
+//******************** ReplayReader functions ************************
+
+ReplayReader::ReplayReader(const string& path)
+ : m_in(path, ios::binary), m_ok(bool(m_in)), m_fileSize(fileSize(path)), m_loaded(0),
+   m_version(VERSION)
+{
+    ifstream idx(indexPath(path), ios::binary);
+    char entry[INDEX_ENTRY_BYTES];
+    while (idx.read(entry, INDEX_ENTRY_BYTES))
+    {
+        BlockEntry e;
+        e.firstGame = getFixed(entry, 8);
+        e.offset = getFixed(entry + 8, 8);
+        e.games = uint32_t(getFixed(entry + 16, 4));
+        m_index.push_back(e);
+    }
+    m_loaded = m_index.size();
+}
+
+long ReplayReader::games() const
+{
+    return m_index.empty() ? 0 : long(m_index.back().firstGame + m_index.back().games);
+}
+
+  // Read block b into memory and find where each of its games starts
+bool ReplayReader::loadBlock(size_t b)
+{
+    if (b == m_loaded)
+        return true;
+    m_loaded = m_index.size();
+    uint64_t end = (b + 1 < m_index.size() ? m_index[b + 1].offset : m_fileSize);
+    if (end < m_index[b].offset)
+        return false;
+    m_block.resize(end - m_index[b].offset);
+    m_in.clear();
+    m_in.seekg(m_index[b].offset);
+    if (!m_in.read(&m_block[0], m_block.size()))
+        return false;
+
+    size_t pos = sizeof(MAGIC);
+    uint64_t version, rows, cols, nShips, nGames;
+    if (m_block.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0 ||
+        !getVarint(m_block, pos, version) || version < FIRST_VERSION || version > VERSION ||
+        !getVarint(m_block, pos, rows) || !getVarint(m_block, pos, cols) ||
+        !getVarint(m_block, pos, nShips) || rows == 0 || cols == 0 ||
+        rows > MAXROWS || cols > MAXCOLS)
+        return false;
+    m_version = version;
+    m_config = ReplayConfig();
+    m_config.rows = int(rows);
+    m_config.cols = int(cols);
+    for (uint64_t s = 0; s < nShips; s++)
+    {
+        ReplayShip ship;
+        uint64_t length, nameLength;
+        if (!getVarint(m_block, pos, length) || pos >= m_block.size())
+            return false;
+        ship.length = int(length);
+        ship.symbol = m_block[pos++];
+        if (!getVarint(m_block, pos, nameLength) || pos + nameLength > m_block.size())
+            return false;
+        ship.name = m_block.substr(pos, nameLength);
+        pos += nameLength;
+        m_config.ships.push_back(ship);
+    }
+    if (!getVarint(m_block, pos, nGames) || nGames != m_index[b].games)
+        return false;
+    m_gameStarts.clear();
+    for (uint64_t k = 0; k < nGames; k++)
+    {
+        uint64_t length;
+        if (!getVarint(m_block, pos, length) || pos + length > m_block.size())
+            return false;
+        m_gameStarts.push_back(pos);
+        pos += length;
+    }
+    m_loaded = b;
+    return true;
+}
+
+bool ReplayReader::readGame(long n, ReplayGame& out)
+{
+    if (!m_ok || n < 0 || n >= games())
+        return false;
+      // The last block whose first game is at most n
+    size_t b = upper_bound(m_index.begin(), m_index.end(), uint64_t(n),
+                           [](uint64_t game, const BlockEntry& e) { return game < e.firstGame; })
+               - m_index.begin() - 1;
+    if (!loadBlock(b))
+        return false;
+
+    out = ReplayGame();
+    out.config = m_config;
+    size_t pos = m_gameStarts[n - m_index[b].firstGame];
+    out.winnerIndex = static_cast<unsigned char>(m_block[pos++]);
+    if (out.winnerIndex > 1)
+        return false;
+    if (m_version >= 2)
+    {
+        if (!getVarint(m_block, pos, out.seed) || !getVarint(m_block, pos, out.gameIndex))
+            return false;
+        out.hasSeed = true;
+    }
+    int cols = m_config.cols;
+    for (int seat = 0; seat < 2; seat++)
+    {
+        for (size_t s = 0; s < m_config.ships.size(); s++)
+        {
+            uint64_t v;
+            if (!getVarint(m_block, pos, v))
+                return false;
+            ShipPlacement sp;
+            sp.topOrLeft = Point(int(v >> 1) / cols, int(v >> 1) % cols);
+            sp.dir = (v & 1) ? VERTICAL : HORIZONTAL;
+            out.fleets[seat].push_back(sp);
+        }
+    }
+    uint64_t nShots;
+    if (!getVarint(m_block, pos, nShots))
+        return false;
+    for (uint64_t k = 0; k < nShots; k++)
+    {
+        uint64_t v;
+        if (!getVarint(m_block, pos, v))
+            return false;
+        ShotEvent e;
+        e.shooter = int(k % 2);
+        e.p = Point(int(v >> 2) / cols, int(v >> 2) % cols);
+        ShotCode code = ShotCode(v & 3);
+        e.validShot = (code != SHOT_INVALID);
+        e.shotHit = (code == SHOT_HIT || code == SHOT_SUNK);
+        e.shipDestroyed = (code == SHOT_SUNK);
+        out.shots.push_back(e);
+    }
+    return true;
+}
+
+//******************** Replay functions ******************************
+
+unique_ptr<Game> makeReplayGame(const ReplayConfig& config)
+{
+    unique_ptr<Game> g(new Game(config.rows, config.cols));
+    for (const ReplayShip& s : config.ships)
+        g->addShip(s.length, s.symbol, s.name);
+    return g;
+}
+
+bool replayBoards(const ReplayGame& rg, long turns, Board& b1, Board& b2)
+{
+    Board* boards[2] = { &b1, &b2 };
+    for (int seat = 0; seat < 2; seat++)
+    {
+        boards[seat]->clear();
+        const vector<ShipPlacement>& fleet = rg.fleets[seat];
+        for (size_t s = 0; s < fleet.size(); s++)
+            if (!boards[seat]->placeShip(fleet[s].topOrLeft, int(s), fleet[s].dir))
+                return false;
+    }
+    turns = min<long>(turns, rg.shots.size());
+    for (long k = 0; k < turns; k++)
+    {
+        const ShotEvent& e = rg.shots[k];
+        if (!e.validShot)
+            continue;
+        bool hit, destroyed;
+        int shipId;
+        if (!boards[1 - e.shooter]->attack(e.p, hit, destroyed, shipId) ||
+            hit != e.shotHit || destroyed != e.shipDestroyed)
+            return false;
+    }
+    return true;
+}
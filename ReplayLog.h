@@ -0,0 +1,157 @@
+#ifndef REPLAYLOG_INCLUDED
+#define REPLAYLOG_INCLUDED
+
+#include "globals.h"
+#include "GameSink.h"
+#include "FleetGenerator.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <cstdint>
+
+// A replay log is a file of blocks, each holding a game configuration and
+// up to GAMES_PER_BLOCK games played with it, plus a sidecar index
+// (the log's path with ".idx" appended) giving each block's first game
+// number and file offset.  Within a block every game is
+//
+//     varint length of the rest
+//     byte   winning seat
+//     varint seed                 the game's Game::seed and gameIndex
+//     varint game index
+//     varint cell << 1 | dir      for each ship of seat 0, then of seat 1
+//     varint number of shots
+//     varint cell << 2 | result   for each shot, seats alternating from 0
+//
+// where result is 0 for a miss, 1 for a hit, 2 for a hit that sank a ship
+// and 3 for an invalid shot, so a shot on a board of up to 32 cells takes
+// one byte and on a board of up to 4096 cells two.
+//
+// Games are numbered in the order they were appended.  With several
+// threads recording, that is the order games finished, not the order of
+// their game indexes; the seed and game index stored with each game are
+// what replays it.  Logs of version 1 have neither.
+
+class Game;
+class Board;
+
+struct ReplayShip
+{
+    int length = 0;
+    char symbol = ' ';
+    std::string name;
+};
+
+  // The board size and ships a logged game was played with
+struct ReplayConfig
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<ReplayShip> ships;
+};
+
+  // One game read back from a log.  The shots' shipIds are -1; replaying
+  // the shots on boards recovers them.
+struct ReplayGame
+{
+    ReplayConfig config;
+    std::vector<ShipPlacement> fleets[2];   // indexed by shipId, per seat
+    int winnerIndex = -1;
+    bool hasSeed = false;       // false for a version 1 log
+    uint64_t seed = 0;
+    uint64_t gameIndex = 0;
+    std::vector<ShotEvent> shots;
+};
+
+  // Appends games to a log, starting a new block after any already there.
+  // Games are buffered a block at a time and written when a block fills,
+  // on flush() and when the log is destroyed.  Safe to share between
+  // threads; each thread records through its own ReplayRecorder.
+class ReplayLog
+{
+  public:
+    static const int GAMES_PER_BLOCK = 1024;
+
+    ReplayLog(const Game& g, const std::string& path);
+    ~ReplayLog();
+    bool ok() const { return m_ok; }
+      // Games in the log so far, including those written before it was opened
+    long games() const;
+      // Append one encoded game; returns its game number
+    long append(const std::string& record);
+    void flush();
+    ReplayLog(const ReplayLog&) = delete;
+    ReplayLog& operator=(const ReplayLog&) = delete;
+
+  private:
+    void writeBlock();
+
+    std::string m_path;
+    std::string m_header;      // the block header for this configuration
+    bool m_ok;
+    mutable std::mutex m_mutex;
+    uint64_t m_games;          // games written or buffered
+    uint64_t m_offset;         // where the next block goes
+    std::string m_block;       // the games of the current block
+    int m_blockGames;
+};
+
+  // A GameSink that encodes each game it sees and appends it to a log
+class ReplayRecorder : public GameSink
+{
+  public:
+    ReplayRecorder(ReplayLog& log, const Game& g);
+    virtual void shipsPlaced(const Board& b1, const Board& b2);
+    virtual void shotFired(const Player& attacker, const ShotEvent& e, const Board& target);
+    virtual void gameOver(const Player* winner);
+
+  private:
+    ReplayLog& m_log;
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    std::string m_fleets;
+    std::string m_shots;
+    long m_nShots = 0;
+    int m_lastShooter = 1;
+};
+
+  // Reads games from a log by number, through its index, parsing only the
+  // block that holds the game asked for
+class ReplayReader
+{
+  public:
+    ReplayReader(const std::string& path);
+    bool ok() const { return m_ok; }
+    long games() const;
+    bool readGame(long n, ReplayGame& out);
+
+  private:
+    struct BlockEntry
+    {
+        uint64_t firstGame;
+        uint64_t offset;
+        uint32_t games;
+    };
+    bool loadBlock(size_t b);
+
+    std::ifstream m_in;
+    bool m_ok;
+    std::vector<BlockEntry> m_index;
+    uint64_t m_fileSize;
+    size_t m_loaded;           // the block in m_block, or m_index.size()
+    std::string m_block;
+    ReplayConfig m_config;     // of the loaded block
+    uint64_t m_version;        // of the loaded block
+    std::vector<size_t> m_gameStarts;  // offsets of its games in m_block
+};
+
+  // A Game with a logged configuration
+std::unique_ptr<Game> makeReplayGame(const ReplayConfig& config);
+  // Set two empty boards of a game made by makeReplayGame to where they
+  // stood after the first turns shots of a logged game; seat 0 fires at b2
+  // and seat 1 at b1.  Returns false if the log doesn't fit the boards.
+bool replayBoards(const ReplayGame& rg, long turns, Board& b1, Board& b2);
+
+#endif // REPLAYLOG_INCLUDED
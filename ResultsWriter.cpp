@@ -0,0 +1,134 @@
+#include "ResultsWriter.h"
+#include "GameSink.h"
+#include <cstdio>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+GameRecord makeGameRecord(long k, int firstMover, const GameResult& r)
+{
+    GameRecord rec;
+    rec.game = k;
+    rec.firstMover = firstMover;
+      // Seat s is side (firstMover + s) % 2
+    if (r.winner != nullptr)
+        rec.winner = (firstMover + r.winnerIndex) % 2;
+    for (int s = 0; s < 2; s++)
+    {
+        int side = (firstMover + s) % 2;
+        rec.shots[side] = r.shots[s];
+        rec.placeRetries[side] = r.placeRetries[s];
+        rec.overruns[side] = r.overruns[s];
+        rec.placeMs[side] = r.placeMs[s];
+        rec.moveMs[side] = r.moveMs[s];
+    }
+    rec.elapsedMs = r.elapsedMs;
+    return rec;
+}
+
+//******************** ResultsWriter functions ***********************
+
+ResultsWriter::ResultsWriter(const string& path)
+ : m_out(path, ios::binary), m_closing(false), m_ok(bool(m_out))
+{
+    m_out << "game,first,winner,shots1,shots2,retries1,retries2,overruns1,overruns2,"
+             "place_ms1,place_ms2,move_ms1,move_ms2,game_ms\n";
+    m_out.flush();
+    m_thread = thread(&ResultsWriter::writeLoop, this);
+}
+
+ResultsWriter::~ResultsWriter()
+{
+    close();
+}
+
+bool ResultsWriter::ok() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_ok;
+}
+
+void ResultsWriter::submit(string& text)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_space.wait(lock, [this] { return m_queue.size() < MAX_QUEUED; });
+    m_queue.push_back(move(text));
+    if (!m_free.empty())
+    {
+        text = move(m_free.back());
+        m_free.pop_back();
+    }
+    else
+        text = string();
+    m_ready.notify_one();
+}
+
+void ResultsWriter::close()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_ready.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+  // Write queued buffers in order until closed with nothing left
+void ResultsWriter::writeLoop()
+{
+    unique_lock<mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_ready.wait(lock, [this] { return !m_queue.empty() || m_closing; });
+        if (m_queue.empty())
+            break;
+        string text = move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+        m_out.write(text.data(), text.size());
+        m_out.flush();
+        bool good = bool(m_out);
+        text.clear();
+        lock.lock();
+        if (!good)
+            m_ok = false;
+        if (m_free.size() < MAX_QUEUED)
+            m_free.push_back(move(text));
+        m_space.notify_all();
+    }
+}
+
+//******************** ResultsChannel functions **********************
+
+ResultsChannel::ResultsChannel(ResultsWriter& writer)
+ : m_writer(writer)
+{
+    m_text.reserve(ResultsWriter::BUFFER_BYTES);
+}
+
+ResultsChannel::~ResultsChannel()
+{
+    flush();
+}
+
+void ResultsChannel::add(const GameRecord& rec)
+{
+    char line[256];
+    int n = snprintf(line, sizeof(line),
+                     "%ld,%d,%d,%d,%d,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                     rec.game, rec.firstMover + 1, rec.winner + 1,
+                     rec.shots[0], rec.shots[1], rec.placeRetries[0], rec.placeRetries[1],
+                     rec.overruns[0], rec.overruns[1], rec.placeMs[0], rec.placeMs[1],
+                     rec.moveMs[0], rec.moveMs[1], rec.elapsedMs);
+    m_text.append(line, min<size_t>(n, sizeof(line) - 1));
+    if (m_text.size() >= ResultsWriter::BUFFER_BYTES)
+        m_writer.submit(m_text);
+}
+
+void ResultsChannel::flush()
+{
+    if (!m_text.empty())
+        m_writer.submit(m_text);
+}
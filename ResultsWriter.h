@@ -0,0 +1,86 @@
+#ifndef RESULTSWRITER_INCLUDED
+#define RESULTSWRITER_INCLUDED
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
+
+struct GameResult;
+
+  // One game of a run, with sides numbered like the contestants of a
+  // tournament rather than by seat
+struct GameRecord
+{
+    long game = 0;
+    int firstMover = 0;          // the side that moved first
+    int winner = -1;             // -1 if a side could not place its ships
+    int shots[2] = { 0, 0 };
+    int placeRetries[2] = { 0, 0 };
+    int overruns[2] = { 0, 0 };
+    double placeMs[2] = { 0, 0 };
+    double moveMs[2] = { 0, 0 };
+    double elapsedMs = 0;
+};
+
+  // Build the record of game k from a GameResult in which side firstMover
+  // had seat 0
+GameRecord makeGameRecord(long k, int firstMover, const GameResult& r);
+
+  // Streams per-game records to a CSV file.  Simulation threads format
+  // records into their own ResultsChannel, which hands the writer whole
+  // buffers of lines; a background thread writes each buffer and flushes
+  // it, so the file always ends on a complete line and can be read while
+  // the run goes on.  At most MAX_QUEUED buffers wait to be written; past
+  // that, channels block until the disk catches up, which bounds memory.
+class ResultsWriter
+{
+  public:
+    static const size_t BUFFER_BYTES = 1 << 16;
+    static const size_t MAX_QUEUED = 16;
+
+    ResultsWriter(const std::string& path);
+    ~ResultsWriter();
+    bool ok() const;
+      // Queue text for writing and replace it with an empty buffer
+    void submit(std::string& text);
+      // Write everything queued and stop the writing thread
+    void close();
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+  private:
+    void writeLoop();
+
+    std::ofstream m_out;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;    // signalled when text is queued
+    std::condition_variable m_space;    // signalled when a buffer is written
+    std::deque<std::string> m_queue;
+    std::vector<std::string> m_free;    // written buffers, for reuse
+    bool m_closing;
+    bool m_ok;
+    std::thread m_thread;
+};
+
+  // One simulation thread's way into a ResultsWriter
+class ResultsChannel
+{
+  public:
+    ResultsChannel(ResultsWriter& writer);
+    ~ResultsChannel();
+    void add(const GameRecord& rec);
+      // Hand over whatever is buffered
+    void flush();
+    ResultsChannel(const ResultsChannel&) = delete;
+    ResultsChannel& operator=(const ResultsChannel&) = delete;
+
+  private:
+    ResultsWriter& m_writer;
+    std::string m_text;
+};
+
+#endif // RESULTSWRITER_INCLUDED
@@ -0,0 +1,129 @@
+#include "ShotSelector.h"
+#include <algorithm>
+
+using namespace std;
+
+//******************** CellPool functions ****************************
+
+CellPool::CellPool(int nRows, int nCols)
+ : m_cols(nCols), m_left(nRows * nCols), m_sparse(nRows * nCols > DENSE_CELLS)
+{
+    if (!m_sparse)
+    {
+        m_slots.resize(m_left);
+        m_positions.resize(m_left);
+        for (int i = 0; i < m_left; i++)
+            m_slots[i] = m_positions[i] = i;
+    }
+}
+
+int CellPool::draw(RandomStream& rs)
+{
+    if (m_left == 0)
+        return -1;
+    int cell = slot(rs.below(m_left));
+    remove(cell);
+    return cell;
+}
+
+Point CellPool::drawPoint(RandomStream& rs)
+{
+    int cell = draw(rs);
+    if (cell < 0)
+        return Point(-1, -1);
+    return Point(cell / m_cols, cell % m_cols);
+}
+
+void CellPool::remove(int cell)
+{
+    int i = position(cell);
+    if (i >= m_left)
+        return;
+    int last = slot(m_left - 1);
+    setSlot(i, last);
+    setPosition(last, i);
+    setPosition(cell, m_left - 1);
+    m_left--;
+      // Slots past the untried ones are never read again, so the sparse
+      // maps can drop them rather than grow
+    if (m_sparse)
+        m_slotMap.erase(m_left);
+}
+
+  // In sparse mode a slot or position missing from its map holds the
+  // identity, which is what every slot holds before the first removal
+
+int CellPool::slot(int i) const
+{
+    if (!m_sparse)
+        return m_slots[i];
+    unordered_map<int, int>::const_iterator it = m_slotMap.find(i);
+    return it == m_slotMap.end() ? i : it->second;
+}
+
+int CellPool::position(int cell) const
+{
+    if (!m_sparse)
+        return m_positions[cell];
+    unordered_map<int, int>::const_iterator it = m_positionMap.find(cell);
+    return it == m_positionMap.end() ? cell : it->second;
+}
+
+void CellPool::setSlot(int i, int cell)
+{
+    if (!m_sparse)
+        m_slots[i] = cell;
+    else if (cell == i)
+        m_slotMap.erase(i);
+    else
+        m_slotMap[i] = cell;
+}
+
+void CellPool::setPosition(int cell, int i)
+{
+    if (!m_sparse)
+        m_positions[cell] = i;
+    else if (i == cell)
+        m_positionMap.erase(cell);
+    else
+        m_positionMap[cell] = i;
+}
+
+//******************** LineTable functions ***************************
+
+LineTable::LineTable(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols)
+{
+    m_step[LINE_UP] = -nCols;
+    m_step[LINE_DOWN] = nCols;
+    m_step[LINE_LEFT] = -1;
+    m_step[LINE_RIGHT] = 1;
+}
+
+int LineTable::reach(int r, int c, LineDirection d) const
+{
+    int room;
+    switch (d)
+    {
+      case LINE_UP:    room = r; break;
+      case LINE_DOWN:  room = m_rows - 1 - r; break;
+      case LINE_LEFT:  room = c; break;
+      default:         room = m_cols - 1 - c; break;
+    }
+    return min(room, MAX_REACH);
+}
+
+void LineTable::untriedInLine(int cell, const CellPool& pool, initializer_list<LineDirection> dirs,
+                              int maxReach, vector<int>& out) const
+{
+    int r = cell / m_cols;
+    int c = cell - r * m_cols;
+    for (int d = 1; d <= maxReach && d <= MAX_REACH; d++)
+    {
+        for (LineDirection ld : dirs)
+        {
+            if (d <= reach(r, c, ld) && pool.contains(cell + d * m_step[ld]))
+                out.push_back(cell + d * m_step[ld]);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef SHOTSELECTOR_INCLUDED
+#define SHOTSELECTOR_INCLUDED
+
+#include "globals.h"
+#include "Random.h"
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include <cstdint>
+
+  // The cells of a board a player has not yet shot at, as a Fisher-Yates
+  // array: the untried cells fill slots [0, size()), so a uniform draw is one
+  // random slot and removing a cell swaps it with the last untried slot.
+  // Both take constant time however full the board is.  Boards above
+  // DENSE_CELLS cells keep only the slots and positions that differ from
+  // the identity, so memory grows with the shots taken.
+class CellPool
+{
+  public:
+    static const int DENSE_CELLS = 4096;
+
+    CellPool(int nRows, int nCols);
+    int size() const { return m_left; }
+    bool empty() const { return m_left == 0; }
+    bool contains(int cell) const { return position(cell) < m_left; }
+    bool contains(Point p) const { return contains(p.r * m_cols + p.c); }
+      // Remove and return a uniformly chosen untried cell, or -1 (a Point
+      // off the board) if every cell has been tried
+    int draw(RandomStream& rs);
+    Point drawPoint(RandomStream& rs);
+      // Remove a cell if it is still untried
+    void remove(int cell);
+    void remove(Point p) { remove(p.r * m_cols + p.c); }
+
+  private:
+    int slot(int i) const;
+    int position(int cell) const;
+    void setSlot(int i, int cell);
+    void setPosition(int cell, int i);
+
+    int m_cols;
+    int m_left;
+    bool m_sparse;
+    std::vector<int> m_slots;     // dense: the cell in each slot
+    std::vector<int> m_positions; // dense: the slot of each cell
+    std::unordered_map<int, int> m_slotMap;
+    std::unordered_map<int, int> m_positionMap;
+};
+
+  // The four directions a line of cells can run from a cell
+enum LineDirection { LINE_UP, LINE_DOWN, LINE_LEFT, LINE_RIGHT };
+
+  // For a board shape, how far each direction runs from a cell before the
+  // edge, capped at MAX_REACH, so the cells in line with a hit are walked
+  // without any bounds tests.  The reach is worked out from the cell's row
+  // and column, so a LineTable takes no memory per cell and players on
+  // boards of any size hold one by value.
+class LineTable
+{
+  public:
+    static constexpr int MAX_REACH = 4;
+
+    LineTable(int nRows, int nCols);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+      // Cells cell+step, ..., cell+reach*step lie on the board
+    int reach(int cell, LineDirection d) const
+    {
+        int r = cell / m_cols;
+        return reach(r, cell - r * m_cols, d);
+    }
+    int step(LineDirection d) const { return m_step[d]; }
+      // Append to out the untried cells 1, 2, ..., maxReach steps from cell
+      // in each of dirs, nearest first, the directions in the order given
+    void untriedInLine(int cell, const CellPool& pool, std::initializer_list<LineDirection> dirs,
+                       int maxReach, std::vector<int>& out) const;
+
+  private:
+    int reach(int r, int c, LineDirection d) const;
+
+    int m_rows;
+    int m_cols;
+    int m_step[4];
+};
+
+#endif // SHOTSELECTOR_INCLUDED
@@ -0,0 +1,622 @@
+#include "Solver.h"
+#include "Game.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <cassert>
+
+using namespace std;
+
+namespace
+{
+    const double INFINITE_SHOTS = numeric_limits<double>::infinity();
+      // Outcome codes of a shot: a miss, a hit, or 2+k when ship k sinks
+    const int MISS = 0;
+    const int HIT = 1;
+    const int SUNK = 2;
+    const uint8_t NO_SHIP = 0xff;
+
+    Bitboard mapCells(const vector<int>& cellMap, Bitboard b)
+    {
+        Bitboard mapped;
+        while (b.any())
+        {
+            int c = b.lowest();
+            b.reset(c);
+            mapped.set(cellMap[c]);
+        }
+        return mapped;
+    }
+
+      // Orders Bitboards as 128-bit numbers, high word first
+    bool lessThan(const Bitboard& a, const Bitboard& b)
+    {
+        return a.hi != b.hi ? a.hi < b.hi : a.lo < b.lo;
+    }
+
+    int countLayouts(const vector<uint64_t>& layouts)
+    {
+        int n = 0;
+        for (uint64_t w : layouts)
+            n += __builtin_popcountll(w);
+        return n;
+    }
+
+    string configKey(const Game& g)
+    {
+        string key = to_string(g.rows()) + "x" + to_string(g.cols()) + ",";
+        for (int s = 0; s < g.nShips(); s++)
+            key += to_string(g.shipLength(s)) + " ";
+        return key;
+    }
+}
+
+//*********************************************************************
+//  Memo
+//*********************************************************************
+
+  // Solved states by canonical key, split over shards so threads solving
+  // different states rarely wait on the same lock
+struct OptimalSolver::Memo
+{
+    static const int SHARDS = 64;
+
+    struct Entry
+    {
+        double value;   // expected shots left under optimal play
+        int best;       // the cell to fire at, in the canonical frame
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const { return size_t(k.a); }
+    };
+    struct KeyEqual
+    {
+        bool operator()(const Key& x, const Key& y) const { return x.a == y.a && x.b == y.b; }
+    };
+    struct Shard
+    {
+        mutex m;
+        unordered_map<Key, Entry, KeyHash, KeyEqual> entries;
+    };
+
+    bool find(const Key& k, Entry& e)
+    {
+        Shard& s = shards[k.b % SHARDS];
+        lock_guard<mutex> lock(s.m);
+        unordered_map<Key, Entry, KeyHash, KeyEqual>::const_iterator it = s.entries.find(k);
+        if (it == s.entries.end())
+            return false;
+        e = it->second;
+        return true;
+    }
+
+    void store(const Key& k, const Entry& e)
+    {
+        Shard& s = shards[k.b % SHARDS];
+        lock_guard<mutex> lock(s.m);
+        s.entries[k] = e;
+    }
+
+    void append(vector<SolvedState>& states)
+    {
+        for (Shard& s : shards)
+        {
+            lock_guard<mutex> lock(s.m);
+            for (const pair<const Key, Entry>& kv : s.entries)
+            {
+                SolvedState st;
+                st.key = kv.first;
+                st.value = kv.second.value;
+                st.best = kv.second.best;
+                states.push_back(st);
+            }
+        }
+    }
+
+    Shard shards[SHARDS];
+};
+
+//*********************************************************************
+//  OptimalSolver
+//*********************************************************************
+
+OptimalSolver::OptimalSolver(const Game& g)
+ : m_rows(g.rows()), m_cols(g.cols()), m_cells(g.rows() * g.cols()), m_nShips(g.nShips()),
+   m_fits(false), m_nLayouts(0), m_words(0), m_memo(new Memo), m_states(0)
+{
+    for (int s = 0; s < m_nShips; s++)
+        m_lengths.push_back(g.shipLength(s));
+    if (m_cells > BITBOARD_CELLS || m_nShips < 1 || m_nShips >= NO_SHIP)
+        return;
+    vector<Bitboard> masks(m_nShips);
+    if (!enumerate(0, Bitboard(), masks) || m_occupied.empty())
+        return;
+    m_nLayouts = m_occupied.size();
+    m_words = (m_nLayouts + 63) / 64;
+
+    m_shipAt.assign(size_t(m_nLayouts) * m_cells, NO_SHIP);
+    m_occupiedAt.assign(size_t(m_cells) * m_words, 0);
+    for (int l = 0; l < m_nLayouts; l++)
+    {
+        for (int s = 0; s < m_nShips; s++)
+        {
+            Bitboard m = m_shipMask[l * m_nShips + s];
+            while (m.any())
+            {
+                int c = m.lowest();
+                m.reset(c);
+                m_shipAt[size_t(l) * m_cells + c] = uint8_t(s);
+                m_occupiedAt[size_t(c) * m_words + l / 64] |= uint64_t(1) << (l % 64);
+            }
+        }
+    }
+    buildSymmetries();
+    m_fits = true;
+    m_stats.layouts = m_nLayouts;
+    m_stats.symmetries = m_cellMap.size();
+}
+
+OptimalSolver::~OptimalSolver()
+{
+}
+
+  // Place ships ship.. in every way that avoids occupied, appending each
+  // complete layout; false once there are too many to solve
+bool OptimalSolver::enumerate(int ship, Bitboard occupied, vector<Bitboard>& masks)
+{
+    if (ship == m_nShips)
+    {
+        if (int(m_occupied.size()) >= SOLVER_MAX_LAYOUTS)
+            return false;
+        m_occupied.push_back(occupied);
+        m_shipMask.insert(m_shipMask.end(), masks.begin(), masks.end());
+        return true;
+    }
+    int len = m_lengths[ship];
+    for (int vertical = 0; vertical < 2; vertical++)
+    {
+          // A ship of length 1 is the same either way
+        if (vertical && len == 1)
+            break;
+        int lastRow = m_rows - (vertical ? len : 1);
+        int lastCol = m_cols - (vertical ? 1 : len);
+        for (int r = 0; r <= lastRow; r++)
+        {
+            for (int c = 0; c <= lastCol; c++)
+            {
+                Bitboard m = Bitboard::line(r * m_cols + c, len, vertical ? m_cols : 1);
+                if ((m & occupied).any())
+                    continue;
+                masks[ship] = m;
+                if (!enumerate(ship + 1, occupied | m, masks))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+  // The reflections and rotations that map the board onto itself, as
+  // permutations of the cells and of the layouts.  The identity is first.
+void OptimalSolver::buildSymmetries()
+{
+    int nSym = (m_rows == m_cols ? 8 : 4);
+    for (int s = 0; s < nSym; s++)
+    {
+        vector<int> cellMap(m_cells);
+        vector<int> cellUnmap(m_cells);
+        for (int r = 0; r < m_rows; r++)
+        {
+            for (int c = 0; c < m_cols; c++)
+            {
+                int rr = (s & 1 ? m_rows - 1 - r : r);
+                int cc = (s & 2 ? m_cols - 1 - c : c);
+                if (s & 4)
+                    swap(rr, cc);
+                int from = r * m_cols + c;
+                int to = rr * m_cols + cc;
+                cellMap[from] = to;
+                cellUnmap[to] = from;
+            }
+        }
+        m_cellMap.push_back(cellMap);
+        m_cellUnmap.push_back(cellUnmap);
+    }
+
+    map<vector<uint64_t>, int> index;
+    vector<uint64_t> key(2 * m_nShips);
+    for (int l = 0; l < m_nLayouts; l++)
+    {
+        for (int s = 0; s < m_nShips; s++)
+        {
+            key[2 * s] = m_shipMask[l * m_nShips + s].lo;
+            key[2 * s + 1] = m_shipMask[l * m_nShips + s].hi;
+        }
+        index[key] = l;
+    }
+    for (int sym = 0; sym < nSym; sym++)
+    {
+        vector<int> layoutMap(m_nLayouts);
+        for (int l = 0; l < m_nLayouts; l++)
+        {
+            for (int s = 0; s < m_nShips; s++)
+            {
+                Bitboard m = mapCells(m_cellMap[sym], m_shipMask[l * m_nShips + s]);
+                key[2 * s] = m.lo;
+                key[2 * s + 1] = m.hi;
+            }
+            map<vector<uint64_t>, int>::const_iterator it = index.find(key);
+            assert(it != index.end());
+            layoutMap[l] = it->second;
+        }
+        m_layoutMap.push_back(layoutMap);
+    }
+}
+
+  // Find the least image of (shot, layouts) under the symmetries, shot
+  // cells first, and hash it into key.  Returns the symmetry that yields
+  // it; stabilizer gets a bit for each symmetry that maps the state onto
+  // itself.
+int OptimalSolver::canonical(const Bitboard& shot, const vector<uint64_t>& layouts,
+                             Key& key, unsigned& stabilizer) const
+{
+    Bitboard bestShot = shot;
+    vector<uint64_t> best(layouts);
+    vector<uint64_t> mapped(m_words);
+    int bestSym = 0;
+    stabilizer = 1;
+    for (size_t sym = 1; sym < m_cellMap.size(); sym++)
+    {
+        Bitboard s = mapCells(m_cellMap[sym], shot);
+        bool maybeFixed = (s == shot);
+        bool maybeLess = !lessThan(bestShot, s);
+        if (!maybeFixed && !maybeLess)
+            continue;
+        fill(mapped.begin(), mapped.end(), 0);
+        const vector<int>& layoutMap = m_layoutMap[sym];
+        for (int w = 0; w < m_words; w++)
+        {
+            for (uint64_t bits = layouts[w]; bits != 0; bits &= bits - 1)
+            {
+                int l = layoutMap[w * 64 + __builtin_ctzll(bits)];
+                mapped[l / 64] |= uint64_t(1) << (l % 64);
+            }
+        }
+        if (maybeFixed && mapped == layouts)
+            stabilizer |= 1u << sym;
+        if (maybeLess && (lessThan(s, bestShot) || mapped < best))
+        {
+            bestShot = s;
+            best.swap(mapped);
+            bestSym = sym;
+        }
+    }
+    key.a = mix64(bestShot.lo ^ 0x736f6c7665ULL);
+    key.b = mix64(bestShot.hi ^ 0x6f7074696d616cULL);
+    for (int w = 0; w < m_words; w++)
+    {
+        key.a = mix64(key.a ^ best[w]);
+        key.b = mix64(key.b ^ (best[w] + 0x9e3779b97f4a7c15ULL * (w + 1)));
+    }
+    return bestSym;
+}
+
+  // What firing at cell, after shot, would report if layout were the
+  // opponent's
+int OptimalSolver::outcome(int layout, const Bitboard& shot, int cell) const
+{
+    int ship = m_shipAt[size_t(layout) * m_cells + cell];
+    if (ship == NO_SHIP)
+        return MISS;
+    Bitboard after = shot | Bitboard::cell(cell);
+    return m_shipMask[layout * m_nShips + ship].andNot(after).none() ? SUNK + ship : HIT;
+}
+
+  // The cells worth firing at from a state: those some layout still left
+  // occupies, most often occupied first, with only one cell of each set
+  // that the state's own symmetries map onto each other.  Returns how
+  // many layouts are left.
+int OptimalSolver::candidates(const Bitboard& shot, const vector<uint64_t>& layouts,
+                              unsigned stabilizer, vector<int>& cells) const
+{
+    vector<pair<int, int>> ranked;   // (-layouts occupying, cell)
+    for (int c = 0; c < m_cells; c++)
+    {
+        if (shot.test(c))
+            continue;
+        bool repeat = false;
+        for (size_t sym = 1; sym < m_cellMap.size() && !repeat; sym++)
+            repeat = ((stabilizer >> sym) & 1) && m_cellMap[sym][c] < c;
+        if (repeat)
+            continue;
+        const uint64_t* at = &m_occupiedAt[size_t(c) * m_words];
+        int n = 0;
+        for (int w = 0; w < m_words; w++)
+            n += __builtin_popcountll(layouts[w] & at[w]);
+        if (n > 0)
+            ranked.push_back(make_pair(-n, c));
+    }
+    sort(ranked.begin(), ranked.end());
+    cells.clear();
+    for (const pair<int, int>& r : ranked)
+        cells.push_back(r.second);
+    return countLayouts(layouts);
+}
+
+  // Split layouts by the outcome of a shot at cell: parts[code] gets the
+  // layouts with that outcome, sizes[code] how many there are and
+  // first[code] the lowest of them
+void OptimalSolver::split(const Bitboard& shot, const vector<uint64_t>& layouts, int cell,
+                          vector<vector<uint64_t>>& parts, vector<int>& sizes,
+                          vector<int>& first) const
+{
+    int nCodes = SUNK + m_nShips;
+    parts.assign(nCodes, vector<uint64_t>(m_words, 0));
+    sizes.assign(nCodes, 0);
+    first.assign(nCodes, -1);
+    for (int w = 0; w < m_words; w++)
+    {
+        for (uint64_t bits = layouts[w]; bits != 0; bits &= bits - 1)
+        {
+            int l = w * 64 + __builtin_ctzll(bits);
+            int code = outcome(l, shot, cell);
+            parts[code][w] |= bits & -bits;
+            if (sizes[code]++ == 0)
+                first[code] = l;
+        }
+    }
+}
+
+  // Expected shots left from (shot, layouts), n of them, if the next shot
+  // is at cell and play is optimal after it.  Stops adding outcomes once
+  // the total is sure to reach cutoff, returning a value at least cutoff.
+  // complete is cleared if the search gave up inside, and the value is
+  // then meaningless.
+double OptimalSolver::shotValue(const Bitboard& shot, const vector<uint64_t>& layouts, int n,
+                                int cell, double cutoff, Search& search, bool& complete)
+{
+    Bitboard after = shot | Bitboard::cell(cell);
+    vector<vector<uint64_t>> parts;
+    vector<int> sizes, first;
+    split(shot, layouts, cell, parts, sizes, first);
+
+      // Every layout still left needs at least one shot per ship cell not
+      // yet hit, so start from that bound and add each outcome's excess
+    vector<pair<int, int>> order;    // (-size, code) of outcomes that don't end the game
+    vector<int> floor(parts.size(), 0);
+    double total = 1;
+    for (size_t code = 0; code < parts.size(); code++)
+    {
+        if (sizes[code] == 0)
+            continue;
+        const Bitboard& occupied = m_occupied[first[code]];
+        floor[code] = occupied.andNot(after).count();
+        if (floor[code] == 0)
+            continue;
+        total += double(sizes[code]) / n * floor[code];
+        order.push_back(make_pair(-sizes[code], int(code)));
+    }
+    sort(order.begin(), order.end());
+    for (const pair<int, int>& o : order)
+    {
+        if (total >= cutoff)
+            return total;
+        int code = o.second;
+        int best;
+        total += double(sizes[code]) / n *
+                 (value(after, parts[code], best, search, complete) - floor[code]);
+        if (!complete)
+            return total;
+    }
+    return total;
+}
+
+  // Expected shots left from (shot, layouts) under optimal play, with the
+  // cell to fire at put in best.  Once the search has solved its budget of
+  // states it gives up: a state not already solved then clears complete
+  // and gets best -1, and neither it nor any state above it is memoized,
+  // so the memo only ever holds exact values.
+double OptimalSolver::value(const Bitboard& shot, const vector<uint64_t>& layouts, int& best,
+                            Search& search, bool& complete)
+{
+    Key key;
+    unsigned stabilizer;
+    int sym = canonical(shot, layouts, key, stabilizer);
+    Memo::Entry e;
+    if (m_memo->find(key, e))
+    {
+        best = m_cellUnmap[sym][e.best];
+        return e.value;
+    }
+    best = -1;
+    if (search.gaveUp.load(memory_order_relaxed))
+    {
+        complete = false;
+        return 0;
+    }
+
+    vector<int> cells;
+    int n = candidates(shot, layouts, stabilizer, cells);
+    double bestValue = INFINITE_SHOTS;
+    for (int c : cells)
+    {
+        double v = shotValue(shot, layouts, n, c, bestValue, search, complete);
+        if (!complete)
+        {
+            best = -1;
+            return 0;
+        }
+        if (v < bestValue)
+        {
+            bestValue = v;
+            best = c;
+        }
+    }
+    if (best < 0)
+        return 0;
+    if (search.states.fetch_add(1, memory_order_relaxed) + 1 >= SOLVER_MAX_STATES)
+        search.gaveUp.store(true, memory_order_relaxed);
+    m_states.fetch_add(1, memory_order_relaxed);
+    e.value = bestValue;
+    e.best = m_cellMap[sym][best];
+    m_memo->store(key, e);
+    return bestValue;
+}
+
+bool OptimalSolver::solve(int threads)
+{
+    if (!m_fits)
+        return false;
+    Timer timer;
+    Knowledge root;
+    start(root);
+    Key key;
+    unsigned stabilizer;
+    canonical(root.shot, root.layouts, key, stabilizer);
+    vector<int> cells;
+    int n = candidates(root.shot, root.layouts, stabilizer, cells);
+
+      // Each outcome of each first shot is an independent search sharing
+      // the memo.  Nothing is pruned at this depth anyway, since no first
+      // shot's value is known before the others finish.
+    struct Branch
+    {
+        int cell;
+        double weight;              // the chance of this outcome
+        Bitboard after;
+        vector<uint64_t> layouts;
+        double value = 0;
+    };
+    vector<Branch> branches;
+    vector<double> values(cells.size(), 1);
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        vector<vector<uint64_t>> parts;
+        vector<int> sizes, first;
+        split(root.shot, root.layouts, cells[i], parts, sizes, first);
+        Bitboard after = Bitboard::cell(cells[i]);
+        for (size_t code = 0; code < parts.size(); code++)
+        {
+              // An outcome that sinks the last ship ends the game
+            if (sizes[code] == 0 || m_occupied[first[code]].andNot(after).none())
+                continue;
+            Branch b;
+            b.cell = int(i);
+            b.weight = double(sizes[code]) / n;
+            b.after = after;
+            b.layouts = parts[code];
+            branches.push_back(b);
+        }
+    }
+    Search search;
+    atomic<bool> complete(true);
+    WorkStealingPool pool(max(1, threads));
+    pool.parallelFor(branches.size(), 1, [&](int, long begin, long end) {
+        for (long i = begin; i < end; i++)
+        {
+            int best;
+            bool done = true;
+            branches[i].value = value(branches[i].after, branches[i].layouts, best, search, done);
+            if (!done)
+                complete.store(false, memory_order_relaxed);
+        }
+    });
+    for (const Branch& b : branches)
+        values[b.cell] += b.weight * b.value;
+
+    m_stats.states = m_states.load();
+    m_stats.seconds = timer.elapsed() / 1000;
+    m_stats.solved = complete.load();
+    if (!m_stats.solved)
+        return false;
+    size_t best = min_element(values.begin(), values.end()) - values.begin();
+    Memo::Entry e;
+    e.value = values[best];
+    e.best = cells[best];
+    m_memo->store(key, e);
+    m_states.fetch_add(1, memory_order_relaxed);
+    m_stats.states = m_states.load();
+    m_stats.expectedShots = e.value;
+    return true;
+}
+
+void OptimalSolver::start(Knowledge& k) const
+{
+    k.shot = Bitboard();
+    k.layouts.assign(m_words, 0);
+    for (int l = 0; l < m_nLayouts; l++)
+        k.layouts[l / 64] |= uint64_t(1) << (l % 64);
+}
+
+void OptimalSolver::record(Knowledge& k, int cell, bool shotHit, bool shipDestroyed,
+                           int shipId) const
+{
+    if (cell < 0 || cell >= m_cells || k.shot.test(cell))
+        return;
+    int seen = (!shotHit ? MISS : shipDestroyed ? SUNK + shipId : HIT);
+    for (int w = 0; w < m_words; w++)
+    {
+        for (uint64_t bits = k.layouts[w]; bits != 0; bits &= bits - 1)
+        {
+            if (outcome(w * 64 + __builtin_ctzll(bits), k.shot, cell) != seen)
+                k.layouts[w] &= ~(bits & -bits);
+        }
+    }
+    k.shot.set(cell);
+}
+
+int OptimalSolver::bestShot(const Knowledge& k)
+{
+    if (!m_fits || countLayouts(k.layouts) == 0)
+        return -1;
+    int best;
+    Search search;
+    bool complete = true;
+    value(k.shot, k.layouts, best, search, complete);
+    if (complete)
+        return best;
+
+      // Too big to solve from here: the cell the most layouts left cover
+    Key key;
+    unsigned stabilizer;
+    canonical(k.shot, k.layouts, key, stabilizer);
+    vector<int> cells;
+    candidates(k.shot, k.layouts, stabilizer, cells);
+    return cells.empty() ? -1 : cells[0];
+}
+
+int OptimalSolver::stateKey(const Knowledge& k, Key& key) const
+{
+    unsigned stabilizer;
+    return canonical(k.shot, k.layouts, key, stabilizer);
+}
+
+void OptimalSolver::solvedStates(vector<SolvedState>& states) const
+{
+    m_memo->append(states);
+}
+
+//******************** Shared solvers ********************************
+
+OptimalSolver* optimalSolver(const Game& g)
+{
+    static mutex m;
+    static map<string, unique_ptr<OptimalSolver>> solved;  // null if too big
+    lock_guard<mutex> lock(m);
+    string key = configKey(g);
+    map<string, unique_ptr<OptimalSolver>>::iterator it = solved.find(key);
+    if (it != solved.end())
+        return it->second.get();
+    unique_ptr<OptimalSolver> s(new OptimalSolver(g));
+    if (!s->solve(max(1, int(thread::hardware_concurrency()))))
+        s.reset();
+    return (solved[key] = move(s)).get();
+}
@@ -0,0 +1,139 @@
+#ifndef SOLVER_INCLUDED
+#define SOLVER_INCLUDED
+
+#include "Bitboard.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+class Game;
+
+  // The largest problems the solver takes on: fleets with more layouts are
+  // refused outright, and a search that needs more states gives up
+const int SOLVER_MAX_LAYOUTS = 1024;
+const long SOLVER_MAX_STATES = 2000000;
+
+struct SolverStats
+{
+    int layouts = 0;            // legal layouts of the whole fleet
+    int symmetries = 0;         // board symmetries used to merge states
+    long states = 0;            // knowledge states solved
+    double seconds = 0;
+    bool solved = false;
+    double expectedShots = 0;   // from an empty board, under optimal play
+};
+
+  // Solves a small configuration exactly: the policy that sinks a fleet in
+  // the fewest expected shots, when every legal layout of the fleet is
+  // equally likely.  Layouts are enumerated up front as bitmasks, so a
+  // knowledge state is the set of cells shot at plus the set of layouts
+  // still consistent with the results, one bit each.  The expected shots
+  // left from a state is the best, over the cells worth shooting, of one
+  // plus the expectation over the shot's outcomes (miss, hit, or which
+  // ship sank).  States are memoized under a canonical form, the least of
+  // their images under the board's reflections and rotations, so states
+  // that are mirror images are solved once.  Within a state, cells are
+  // tried most likely hit first, and a cell is abandoned as soon as its
+  // partial expectation reaches the best found so far.
+class OptimalSolver
+{
+  public:
+      // What a player has learned about the opponent's board
+    struct Knowledge
+    {
+        Bitboard shot;
+        std::vector<uint64_t> layouts;  // one bit per layout still possible
+    };
+      // A 128-bit hash of the canonical form of a knowledge state, which
+      // is the same for a state and all its mirror images
+    struct Key
+    {
+        uint64_t a;
+        uint64_t b;
+    };
+    struct SolvedState
+    {
+        Key key;
+        double value;   // expected shots left under optimal play
+        int best;       // the cell to fire at, in the canonical frame
+    };
+
+    OptimalSolver(const Game& g);
+    ~OptimalSolver();
+      // Whether the configuration is small enough to try
+    bool fits() const { return m_fits; }
+      // Solve from an empty board, running the outcomes of each first shot
+      // as separate searches over threads (a few dozen at most, so more
+      // threads than that sit idle); false if the search grew past
+      // SOLVER_MAX_STATES
+    bool solve(int threads);
+    const SolverStats& stats() const { return m_stats; }
+    void start(Knowledge& k) const;
+    void record(Knowledge& k, int cell, bool shotHit, bool shipDestroyed, int shipId) const;
+      // The best cell to fire at next, or -1 if no layout is left.  States
+      // off the optimal line may need solving first; if that takes more
+      // than SOLVER_MAX_STATES new states, the cell the most layouts left
+      // cover is returned instead.  Safe to call from any thread.
+    int bestShot(const Knowledge& k);
+      // k's key; returns the symmetry that takes k to its canonical form
+    int stateKey(const Knowledge& k, Key& key) const;
+      // The cell in the frame of a state that a cell of its canonical form
+      // stands for, given the symmetry stateKey returned
+    int fromCanonical(int symmetry, int cell) const { return m_cellUnmap[symmetry][cell]; }
+      // Append every state solved so far to states, in no particular order
+    void solvedStates(std::vector<SolvedState>& states) const;
+    OptimalSolver(const OptimalSolver&) = delete;
+    OptimalSolver& operator=(const OptimalSolver&) = delete;
+
+  private:
+    struct Memo;
+      // One search's count of the states it has solved, against its budget
+      // of SOLVER_MAX_STATES
+    struct Search
+    {
+        std::atomic<long> states{0};
+        std::atomic<bool> gaveUp{false};
+    };
+
+    bool enumerate(int ship, Bitboard occupied, std::vector<Bitboard>& masks);
+    void buildSymmetries();
+    int canonical(const Bitboard& shot, const std::vector<uint64_t>& layouts,
+                  Key& key, unsigned& stabilizer) const;
+    int outcome(int layout, const Bitboard& shot, int cell) const;
+    int candidates(const Bitboard& shot, const std::vector<uint64_t>& layouts,
+                   unsigned stabilizer, std::vector<int>& cells) const;
+    void split(const Bitboard& shot, const std::vector<uint64_t>& layouts, int cell,
+               std::vector<std::vector<uint64_t>>& parts, std::vector<int>& sizes,
+               std::vector<int>& first) const;
+    double value(const Bitboard& shot, const std::vector<uint64_t>& layouts, int& best,
+                 Search& search, bool& complete);
+    double shotValue(const Bitboard& shot, const std::vector<uint64_t>& layouts, int n,
+                     int cell, double cutoff, Search& search, bool& complete);
+
+    int m_rows;
+    int m_cols;
+    int m_cells;
+    int m_nShips;
+    std::vector<int> m_lengths;
+    bool m_fits;
+    int m_nLayouts;
+    int m_words;                            // words in a set of layouts
+    std::vector<Bitboard> m_occupied;       // by layout
+    std::vector<Bitboard> m_shipMask;       // layout * nShips + ship
+    std::vector<uint8_t> m_shipAt;          // layout * cells + cell, 0xff for none
+    std::vector<uint64_t> m_occupiedAt;     // cell * words: the layouts covering it
+    std::vector<std::vector<int>> m_cellMap;    // per symmetry, cell to cell
+    std::vector<std::vector<int>> m_cellUnmap;  // the inverse
+    std::vector<std::vector<int>> m_layoutMap;  // per symmetry, layout to layout
+    std::unique_ptr<Memo> m_memo;
+    std::atomic<long> m_states;             // in the memo
+    SolverStats m_stats;
+};
+
+  // The solved solver for g's configuration, shared by the whole process,
+  // or nullptr if the configuration is too big to solve.  The first call
+  // for a configuration solves it, on as many threads as there are cores.
+OptimalSolver* optimalSolver(const Game& g);
+
+#endif // SOLVER_INCLUDED
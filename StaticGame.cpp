@@ -0,0 +1,31 @@
+#include "StaticGame.h"
+#include <variant>
+
+using namespace std;
+
+namespace
+{
+      // The visitor for a pair of BuiltinPlayers: each pairing of concrete
+      // players gets its own simulateStatic
+    struct PlayPairing
+    {
+        const Game& g;
+        bool recordEvents;
+
+        template <class P1, class P2>
+        GameResult operator()(P1& p1, P2& p2) const
+        {
+            return simulateStatic(g, p1, p2, recordEvents);
+        }
+        template <class P2>
+        GameResult operator()(monostate&, P2&) const { return GameResult(); }
+        template <class P1>
+        GameResult operator()(P1&, monostate&) const { return GameResult(); }
+        GameResult operator()(monostate&, monostate&) const { return GameResult(); }
+    };
+}
+
+GameResult simulateBuiltin(const Game& g, BuiltinPlayer& p1, BuiltinPlayer& p2, bool recordEvents)
+{
+    return visit(PlayPairing{ g, recordEvents }, p1, p2);
+}
@@ -0,0 +1,112 @@
+#ifndef STATICGAME_INCLUDED
+#define STATICGAME_INCLUDED
+
+#include "Game.h"
+#include "Board.h"
+#include "GameSink.h"
+#include "Random.h"
+#include "Timer.h"
+#include "Instrument.h"
+#include "BuiltinPlayers.h"
+
+// The headless game loop of Game::simulate with the players' types known
+// at compile time.  P1 and P2 are concrete Player classes, normally final
+// ones from BuiltinPlayers.h, so every recommendAttack and
+// recordAttackResult is a direct call the compiler can inline.  The game
+// draws on the same streams as Game::simulate with no time budget, so with
+// the same seed and players it plays the very same game.  Time budgets,
+// phase timing and sinks need Game::simulate.
+
+namespace staticgame
+{
+      // Fire attacker's shot at p on target and tell both players; true if
+      // it ended the game
+    template <class A, class D>
+    bool resolveShot(A& attacker, D& defender, Board& target, int a, Point p,
+                     GameResult& result, bool recordEvents)
+    {
+        ShotEvent e;
+        e.shooter = a;
+        e.p = p;
+        e.validShot = target.attack(e.p, e.shotHit, e.shipDestroyed, e.shipId);
+        {
+            BSIM_PROBE(PROBE_RECORD_ATTACK_RESULT);
+            attacker.recordAttackResult(e.p, e.validShot, e.shotHit, e.shipDestroyed, e.shipId);
+        }
+        BSIM_COUNT(COUNTER_SHOTS, 1);
+        BSIM_COUNT(COUNTER_HITS, e.shotHit);
+        defender.recordAttackByOpponent(e.p);
+        result.shots[a]++;
+        if (recordEvents)
+            result.events.push_back(e);
+        return target.allShipsDestroyed();
+    }
+
+      // One turn of attacker against target; true if it ended the game
+    template <class A, class D>
+    bool takeTurn(A& attacker, D& defender, Board& target, int a, GameResult& result,
+                  bool recordEvents)
+    {
+        Point p;
+        {
+            BSIM_PROBE(PROBE_RECOMMEND_ATTACK);
+            p = attacker.recommendAttack();
+        }
+        return resolveShot(attacker, defender, target, a, p, result, recordEvents);
+    }
+
+    template <class P>
+    bool placeFleet(P& p, Board& b)
+    {
+        BSIM_PROBE(PROBE_PLACE_SHIPS);
+        return p.placeShips(b);
+    }
+}
+
+  // Play a game between p1, who moves first, and p2 under g's current seed
+template <class P1, class P2>
+GameResult simulateStatic(const Game& g, P1& p1, P2& p2, bool recordEvents = false)
+{
+    GameResult result;
+    if (g.nShips() == 0)
+        return result;
+    Board b1(g);
+    Board b2(g);
+    b1.setRandomStream(g.randomStream(BOARD1_STREAM));
+    b2.setRandomStream(g.randomStream(BOARD2_STREAM));
+    p1.setRandomStream(g.randomStream(PLAYER1_STREAM));
+    p2.setRandomStream(g.randomStream(PLAYER2_STREAM));
+    p1.setDeadline(Deadline());
+    p2.setDeadline(Deadline());
+    bool placed = staticgame::placeFleet(p1, b1);
+    result.placeRetries[0] = b1.placementRetries();
+    if (!placed)
+        return result;
+    placed = staticgame::placeFleet(p2, b2);
+    result.placeRetries[1] = b2.placementRetries();
+    if (!placed)
+        return result;
+    for (;;)
+    {
+        if (staticgame::takeTurn(p1, p2, b2, 0, result, recordEvents))
+        {
+            result.winnerIndex = 0;
+            result.winner = &p1;
+            break;
+        }
+        if (staticgame::takeTurn(p2, p1, b1, 1, result, recordEvents))
+        {
+            result.winnerIndex = 1;
+            result.winner = &p2;
+            break;
+        }
+    }
+    return result;
+}
+
+  // simulateStatic on whichever players p1 and p2 hold, through one
+  // instantiation per pairing; an empty result if either is empty
+GameResult simulateBuiltin(const Game& g, BuiltinPlayer& p1, BuiltinPlayer& p2,
+                           bool recordEvents = false);
+
+#endif // STATICGAME_INCLUDED
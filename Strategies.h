@@ -0,0 +1,39 @@
+#ifndef STRATEGIES_INCLUDED
+#define STRATEGIES_INCLUDED
+
+#include <string>
+
+class Player;
+class Game;
+
+  // Factories for the computer players that live in their own source files.
+  // createPlayer is the public way to get one of these.  Each factory falls
+  // back to a lighter player when the board is too big for its strategy.
+
+  // The largest board the density player takes on; its per-placement
+  // counters grow with the board, so bigger games get a good player instead
+const int DENSITY_MAX_CELLS = 10000;
+
+  // Fires at the cell covered by the most ship placements still consistent
+  // with what it has seen, updating the counts incrementally after each shot
+Player* createDensityPlayer(std::string nm, const Game& g);
+
+  // Fires at the cell occupied most often across samplesPerMove random fleet
+  // layouts consistent with what it has seen, drawing the samples on
+  // threads worker threads.  Boards that don't fit in a Bitboard get a
+  // density player instead.
+Player* createMonteCarloPlayer(std::string nm, const Game& g,
+                               int samplesPerMove = 1000, int threads = 1);
+
+  // Plays the exact policy that minimizes the expected shots to sink the
+  // fleet, from the OptimalSolver shared by every game of the same
+  // configuration, which is solved on first use.  Configurations too big
+  // to solve get a density player instead.
+Player* createOptimalPlayer(std::string nm, const Game& g);
+
+  // The strategy createPlayer builds for type on g's board: type itself,
+  // or the lighter strategy a density or Monte Carlo player falls back to
+  // there.  Programs print a notice when the two differ.
+std::string playingType(const std::string& type, const Game& g);
+
+#endif // STRATEGIES_INCLUDED
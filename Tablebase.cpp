@@ -0,0 +1,284 @@
+#include "Tablebase.h"
+#include "Game.h"
+#include "Random.h"
+#include "globals.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[8] = { 'B', 'S', 'I', 'M', 'T', 'B', 'A', 'S' };
+
+    uint64_t configKey(const Game& g)
+    {
+        uint64_t key = mix64(0x7461626c65ULL ^ (uint64_t(g.rows()) << 32 | uint64_t(g.cols())));
+        for (int s = 0; s < g.nShips(); s++)
+            key = mix64(key + uint64_t(g.shipLength(s)));
+        return key;
+    }
+
+    mutex sharedMutex;
+    Tablebase sharedBase;
+      // Unsolved solvers, for their layouts and symmetries, by configuration
+    map<uint64_t, unique_ptr<OptimalSolver>> layoutSolvers;
+}
+
+struct Tablebase::Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t nConfigs;
+    uint64_t nRecords;
+};
+
+struct Tablebase::Config
+{
+    uint64_t key;
+    uint64_t first;     // index of its first record
+    uint64_t count;
+};
+
+struct Tablebase::Record
+{
+    uint64_t a;
+    uint64_t b;
+    float value;
+    int32_t best;
+};
+
+Tablebase::Tablebase()
+ : m_base(nullptr), m_size(0), m_configs(nullptr), m_nConfigs(0), m_records(nullptr)
+{
+}
+
+Tablebase::~Tablebase()
+{
+    close();
+}
+
+bool Tablebase::open(const string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header))
+        base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      // The mapping outlives the descriptor
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return false;
+    m_base = static_cast<const unsigned char*>(base);
+    m_size = st.st_size;
+
+    const Header* h = reinterpret_cast<const Header*>(m_base);
+    size_t tableEnd = sizeof(Header) + h->nConfigs * sizeof(Config);
+    if (memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != TABLEBASE_VERSION ||
+        h->recordSize != sizeof(Record) || h->nConfigs > m_size / sizeof(Config) ||
+        h->nRecords > m_size / sizeof(Record) ||
+        tableEnd + h->nRecords * sizeof(Record) > m_size)
+    {
+        close();
+        return false;
+    }
+    m_configs = reinterpret_cast<const Config*>(m_base + sizeof(Header));
+    m_nConfigs = h->nConfigs;
+    m_records = reinterpret_cast<const Record*>(m_base + tableEnd);
+    for (size_t k = 0; k < m_nConfigs; k++)
+    {
+        if (m_configs[k].first > h->nRecords || m_configs[k].count > h->nRecords - m_configs[k].first)
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void Tablebase::close()
+{
+    if (m_base != nullptr)
+        munmap(const_cast<unsigned char*>(m_base), m_size);
+    m_base = nullptr;
+    m_size = 0;
+    m_configs = nullptr;
+    m_nConfigs = 0;
+    m_records = nullptr;
+}
+
+size_t Tablebase::states() const
+{
+    return m_base == nullptr ? 0 : reinterpret_cast<const Header*>(m_base)->nRecords;
+}
+
+int Tablebase::findConfig(const Game& g) const
+{
+    uint64_t key = configKey(g);
+    const Config* end = m_configs + m_nConfigs;
+    const Config* it = lower_bound(m_configs, end, key, [](const Config& c, uint64_t k) {
+        return c.key < k;
+    });
+    return (it != end && it->key == key && it->count > 0) ? int(it - m_configs) : -1;
+}
+
+bool Tablebase::find(int config, const OptimalSolver::Key& key, int cells, Entry& e) const
+{
+    if (config < 0 || size_t(config) >= m_nConfigs)
+        return false;
+    const Record* begin = m_records + m_configs[config].first;
+    const Record* end = begin + m_configs[config].count;
+    const Record* it = lower_bound(begin, end, key, [](const Record& r, const OptimalSolver::Key& k) {
+        return r.a != k.a ? r.a < k.a : r.b < k.b;
+    });
+    if (it == end || it->a != key.a || it->b != key.b || it->best < 0 || it->best >= cells)
+        return false;
+    e.value = it->value;
+    e.best = it->best;
+    return true;
+}
+
+void Tablebase::add(const Game& g, const OptimalSolver& solver)
+{
+    uint64_t key = configKey(g);
+    size_t k = 0;
+    while (k < m_pending.size() && m_pending[k].config != key)
+        k++;
+    if (k == m_pending.size())
+        m_pending.push_back(Pending());
+    m_pending[k].config = key;
+    m_pending[k].states.clear();
+    solver.solvedStates(m_pending[k].states);
+    sort(m_pending[k].states.begin(), m_pending[k].states.end(),
+         [](const OptimalSolver::SolvedState& x, const OptimalSolver::SolvedState& y) {
+             return x.key.a != y.key.a ? x.key.a < y.key.a : x.key.b < y.key.b;
+         });
+}
+
+  // The configurations of the mapped file that nothing added replaces are
+  // copied over.  The file is written beside path and renamed into place,
+  // so processes that have the old one mapped keep reading it unharmed.
+bool Tablebase::write(const string& path) const
+{
+    map<uint64_t, vector<Record>> configs;
+    for (size_t k = 0; k < m_nConfigs; k++)
+    {
+        const Record* first = m_records + m_configs[k].first;
+        configs[m_configs[k].key].assign(first, first + m_configs[k].count);
+    }
+    for (const Pending& p : m_pending)
+    {
+        vector<Record>& records = configs[p.config];
+        records.clear();
+        for (const OptimalSolver::SolvedState& st : p.states)
+        {
+            Record r;
+            r.a = st.key.a;
+            r.b = st.key.b;
+            r.value = float(st.value);
+            r.best = st.best;
+            records.push_back(r);
+        }
+    }
+
+    Header h;
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = TABLEBASE_VERSION;
+    h.recordSize = sizeof(Record);
+    h.nConfigs = configs.size();
+    h.nRecords = 0;
+    vector<Config> table;
+    for (const pair<const uint64_t, vector<Record>>& c : configs)
+    {
+        Config entry;
+        entry.key = c.first;
+        entry.first = h.nRecords;
+        entry.count = c.second.size();
+        h.nRecords += entry.count;
+        table.push_back(entry);
+    }
+
+    string temp = path + ".tmp";
+    ofstream out(temp, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Config));
+    for (const pair<const uint64_t, vector<Record>>& c : configs)
+        out.write(reinterpret_cast<const char*>(c.second.data()), c.second.size() * sizeof(Record));
+      // A full disk may only show when the last buffer is written out on
+      // close, so the stream is checked after that, and a file that isn't
+      // whole never replaces path
+    out.close();
+    if (!out || rename(temp.c_str(), path.c_str()) != 0)
+    {
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+//******************** Shared tablebase ******************************
+
+bool openTablebase(const string& path)
+{
+    lock_guard<mutex> lock(sharedMutex);
+    return sharedBase.open(path);
+}
+
+const Tablebase& sharedTablebase()
+{
+    return sharedBase;
+}
+
+//******************** TablebaseProbe ********************************
+
+TablebaseProbe::TablebaseProbe(const Game& g)
+ : m_cols(g.cols()), m_cells(g.rows() * g.cols()), m_config(sharedBase.findConfig(g)),
+   m_layouts(nullptr)
+{
+    if (m_config < 0)
+        return;
+    {
+        lock_guard<mutex> lock(sharedMutex);
+        unique_ptr<OptimalSolver>& s = layoutSolvers[configKey(g)];
+        if (!s)
+            s.reset(new OptimalSolver(g));
+        m_layouts = s.get();
+    }
+    if (!m_layouts->fits())
+    {
+        m_config = -1;
+        return;
+    }
+    m_layouts->start(m_knowledge);
+}
+
+void TablebaseProbe::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (active())
+        m_layouts->record(m_knowledge, p.r * m_cols + p.c, shotHit, shipDestroyed, shipId);
+}
+
+int TablebaseProbe::bestShot() const
+{
+    if (!active())
+        return -1;
+    OptimalSolver::Key key;
+    int symmetry = m_layouts->stateKey(m_knowledge, key);
+    Tablebase::Entry e;
+    if (!sharedBase.find(m_config, key, m_cells, e))
+        return -1;
+    return m_layouts->fromCanonical(symmetry, e.best);
+}
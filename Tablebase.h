@@ -0,0 +1,104 @@
+#ifndef TABLEBASE_INCLUDED
+#define TABLEBASE_INCLUDED
+
+#include "Solver.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Game;
+class Point;
+
+  // Solved knowledge states of small configurations, stored on disk so that
+  // no process has to solve them again.  A tablebase file is built offline
+  // (see the tablebase program) and opened read-only with mmap, so every
+  // process that opens it shares one copy in the page cache and opening it
+  // reads nothing but the header.
+  //
+  // The file is native-endian: a header, a table of configurations sorted
+  // by key, then each configuration's records sorted by state key.  A
+  // record holds a state's OptimalSolver::Key, its expected shots left and
+  // its best cell, both in the canonical frame.  Keys depend on the order
+  // in which OptimalSolver enumerates layouts, so a change to that order
+  // must bump TABLEBASE_VERSION.
+const uint32_t TABLEBASE_VERSION = 1;
+
+class Tablebase
+{
+  public:
+    struct Entry
+    {
+        float value;    // expected shots left under optimal play
+        int best;       // the cell to fire at, in the canonical frame
+    };
+
+    Tablebase();
+    ~Tablebase();
+      // Map the file at path, replacing any file mapped before; false if
+      // it can't be read or isn't a tablebase of this version
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    size_t configs() const { return m_nConfigs; }
+    size_t states() const;
+      // The index of g's configuration, or -1 if the tablebase has none
+    int findConfig(const Game& g) const;
+      // The state key of configuration config, whose board has cells
+      // cells; false if it isn't there or its best cell isn't on the board,
+      // as only a damaged file would have it
+    bool find(int config, const OptimalSolver::Key& key, int cells, Entry& e) const;
+      // Write every state solver has solved for g's configuration, along
+      // with the configurations of those already added
+    void add(const Game& g, const OptimalSolver& solver);
+    bool write(const std::string& path) const;
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+  private:
+    struct Header;
+    struct Config;
+    struct Record;
+    struct Pending
+    {
+        uint64_t config;
+        std::vector<OptimalSolver::SolvedState> states;
+    };
+
+    const unsigned char* m_base;
+    size_t m_size;
+    const Config* m_configs;
+    size_t m_nConfigs;
+    const Record* m_records;
+    std::vector<Pending> m_pending;
+};
+
+  // The tablebase shared by every player in the process.  Open it before
+  // creating any player, and don't reopen it while one exists, since
+  // players read its mapping.
+bool openTablebase(const std::string& path);
+const Tablebase& sharedTablebase();
+
+  // A player's view of the shared tablebase: the layouts still consistent
+  // with its shots, and the best cell for that state if the tablebase has
+  // it.  Inactive, at the cost of one lookup at construction, when the
+  // tablebase has no states for the game's configuration.
+class TablebaseProbe
+{
+  public:
+    TablebaseProbe(const Game& g);
+    bool active() const { return m_config >= 0; }
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+      // The best cell from here (row * cols + col), or -1 if the state is
+      // not in the tablebase
+    int bestShot() const;
+
+  private:
+    int m_cols;
+    int m_cells;
+    int m_config;
+    const OptimalSolver* m_layouts;
+    OptimalSolver::Knowledge m_knowledge;
+};
+
+#endif // TABLEBASE_INCLUDED
@@ -0,0 +1,110 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(int nThreads)
+    : m_nThreads(nThreads < 1 ? 1 : nThreads), m_body(nullptr),
+      m_generation(0), m_busy(0), m_stop(false)
+{
+    for (int w = 0; w < m_nThreads; w++)
+        m_queues.push_back(unique_ptr<Queue>(new Queue));
+    for (int w = 1; w < m_nThreads; w++)
+        m_threads.push_back(thread(&WorkStealingPool::workerLoop, this, w));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); i++)
+        m_threads[i].join();
+}
+
+void WorkStealingPool::parallelFor(long n, long grain, const function<void(int, long, long)>& body)
+{
+    if (n <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+      // Deal the chunks out round-robin so every worker starts with a share
+      // of the range and stealing only has to even out the tail
+    int w = 0;
+    for (long begin = 0; begin < n; begin += grain)
+    {
+        Range r = { begin, begin + grain < n ? begin + grain : n };
+        m_queues[w]->ranges.push_back(r);
+        w = (w + 1) % m_nThreads;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_body = &body;
+        m_busy = m_nThreads - 1;
+        m_generation++;
+    }
+    m_wake.notify_all();
+    runChunks(0);
+
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_body = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int w)
+{
+    long seen = 0;
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+        }
+        runChunks(w);
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::runChunks(int w)
+{
+    Range r;
+    while (popLocal(w, r) || steal(w, r))
+        (*m_body)(w, r.begin, r.end);
+}
+
+bool WorkStealingPool::popLocal(int w, Range& r)
+{
+    Queue& q = *m_queues[w];
+    lock_guard<mutex> lock(q.m);
+    if (q.ranges.empty())
+        return false;
+    r = q.ranges.back();
+    q.ranges.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int w, Range& r)
+{
+    for (int k = 1; k < m_nThreads; k++)
+    {
+        Queue& q = *m_queues[(w + k) % m_nThreads];
+        lock_guard<mutex> lock(q.m);
+        if (!q.ranges.empty())
+        {
+            r = q.ranges.front();
+            q.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
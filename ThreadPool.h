@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+
+  // A fixed set of worker threads that split an index range into chunks.
+  // Each worker owns a deque of chunks; it takes work from the back of its
+  // own deque and, once that runs dry, steals from the front of another
+  // worker's.  The thread calling parallelFor acts as worker 0.
+class WorkStealingPool
+{
+  public:
+    explicit WorkStealingPool(int nThreads);
+    ~WorkStealingPool();
+    int size() const { return m_nThreads; }
+      // Call body(worker, begin, end) over chunks of at most grain indices
+      // covering [0,n), and return once every chunk has run.  worker is in
+      // [0,size()) and identifies the calling thread for per-thread state.
+    void parallelFor(long n, long grain, const std::function<void(int, long, long)>& body);
+      // We prevent a WorkStealingPool object from being copied or assigned
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  private:
+    struct Range
+    {
+        long begin;
+        long end;
+    };
+    struct Queue
+    {
+        std::mutex m;
+        std::deque<Range> ranges;
+    };
+    void workerLoop(int w);
+    void runChunks(int w);
+    bool popLocal(int w, Range& r);
+    bool steal(int w, Range& r);
+
+    int m_nThreads;
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(int, long, long)>* m_body;
+    long m_generation;
+    int m_busy;
+    bool m_stop;
+};
+
+#endif // THREADPOOL_INCLUDED
@@ -0,0 +1,73 @@
+#ifndef TIMER_INCLUDED
+#define TIMER_INCLUDED
+
+#include <chrono>
+#include <limits>
+
+//========================================================================
+// Timer t;                 // create a timer and start it
+// t.start();               // start the timer
+// double d = t.elapsed();  // milliseconds since timer was last started
+//========================================================================
+
+class Timer
+{
+public:
+    Timer()
+    {
+        start();
+    }
+    void start()
+    {
+        m_time = std::chrono::high_resolution_clock::now();
+    }
+    double elapsed() const
+    {
+        std::chrono::duration<double, std::milli> diff =
+            std::chrono::high_resolution_clock::now() - m_time;
+        return diff.count();
+    }
+private:
+    std::chrono::high_resolution_clock::time_point m_time;
+};
+
+//========================================================================
+// Deadline d(50);          // 50 milliseconds from now
+// Deadline none;           // no deadline at all
+// d.expired();             // whether the time has passed
+// d.remaining();           // milliseconds left, or infinity if none
+//========================================================================
+
+class Deadline
+{
+public:
+    Deadline() : m_set(false)
+    {}
+    explicit Deadline(double ms)
+     : m_set(true),
+       m_time(std::chrono::steady_clock::now() +
+              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double, std::milli>(ms)))
+    {}
+    bool isSet() const
+    {
+        return m_set;
+    }
+    bool expired() const
+    {
+        return m_set && std::chrono::steady_clock::now() >= m_time;
+    }
+    double remaining() const
+    {
+        if (!m_set)
+            return std::numeric_limits<double>::infinity();
+        std::chrono::duration<double, std::milli> left =
+            m_time - std::chrono::steady_clock::now();
+        return left.count();
+    }
+private:
+    bool m_set;
+    std::chrono::steady_clock::time_point m_time;
+};
+
+#endif // TIMER_INCLUDED
@@ -0,0 +1,214 @@
+#include "Tournament.h"
+#include "ThreadPool.h"
+#include "Game.h"
+#include "GameSink.h"
+#include "Player.h"
+#include "Timer.h"
+#include "ReplayLog.h"
+#include "ResultsWriter.h"
+#include "BatchEngine.h"
+#include "StaticGame.h"
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+namespace
+{
+      // Per-worker tallies, padded so neighbouring workers never share a
+      // cache line
+    struct alignas(64) Tally
+    {
+        long games = 0;
+        long wins[2] = { 0, 0 };
+        long shots[2] = { 0, 0 };
+        long overruns[2] = { 0, 0 };
+        long failed = 0;
+    };
+
+      // Games handed to a worker at a time on the batch path: enough to
+      // fill a wave on each of its two engines
+    const long BATCH_GRAIN = 4096;
+
+    bool canBatch(const TournamentConfig& cfg, BatchStrategy s[2])
+    {
+        return cfg.batch && cfg.moveMs <= 0 && cfg.gameMs <= 0 &&
+               cfg.recordPath.empty() && cfg.resultsPath.empty() &&
+               batchStrategy(cfg.type1, s[0]) && batchStrategy(cfg.type2, s[1]);
+    }
+
+      // Each worker has one engine with contestant 0 in seat 0 for the
+      // even-numbered games and one with the seats swapped for the odd ones
+    void runBatches(const TournamentConfig& cfg, const BatchStrategy s[2],
+                    WorkStealingPool& pool, vector<Tally>& tallies)
+    {
+        Game g(cfg.rows, cfg.cols);
+        addTournamentShips(g, cfg);
+        vector<unique_ptr<BatchEngine>> engines(2 * pool.size());
+        for (int w = 0; w < pool.size(); w++)
+        {
+            engines[2 * w].reset(new BatchEngine(g, s[0], s[1]));
+            engines[2 * w + 1].reset(new BatchEngine(g, s[1], s[0]));
+        }
+        pool.parallelFor(cfg.games, BATCH_GRAIN, [&](int w, long begin, long end) {
+            Tally& t = tallies[w];
+            for (int odd = 0; odd < 2; odd++)
+            {
+                long first = begin + ((begin + odd) % 2);
+                if (first >= end)
+                    continue;
+                BatchResult r;
+                engines[2 * w + odd]->run(cfg.seed, first, (end - first + 1) / 2, 2, r);
+                t.games += r.games;
+                t.failed += r.failed;
+                for (int seat = 0; seat < 2; seat++)
+                {
+                    t.wins[(seat + odd) % 2] += r.wins[seat];
+                    t.shots[(seat + odd) % 2] += r.shots[seat];
+                }
+            }
+        });
+    }
+
+      // Play the games one at a time through Game::simulate; returns the
+      // seconds taken
+    double playGames(const TournamentConfig& cfg, WorkStealingPool& pool, vector<Tally>& tallies,
+                     TournamentResult& result)
+    {
+        vector<unique_ptr<Game>> games(pool.size());
+        for (int w = 0; w < pool.size(); w++)
+        {
+            games[w].reset(new Game(cfg.rows, cfg.cols));
+            addTournamentShips(*games[w], cfg);
+            games[w]->setTimeBudget(cfg.moveMs, cfg.gameMs, cfg.overrunPolicy);
+            games[w]->setPhaseTiming(!cfg.resultsPath.empty());
+        }
+        unique_ptr<ReplayLog> log;
+        vector<unique_ptr<ReplayRecorder>> recorders(pool.size());
+        if (!cfg.recordPath.empty())
+        {
+            log.reset(new ReplayLog(*games[0], cfg.recordPath));
+            for (int w = 0; w < pool.size(); w++)
+                recorders[w].reset(new ReplayRecorder(*log, *games[w]));
+        }
+        unique_ptr<ResultsWriter> results;
+        vector<unique_ptr<ResultsChannel>> channels(pool.size());
+        if (!cfg.resultsPath.empty())
+        {
+            results.reset(new ResultsWriter(cfg.resultsPath));
+            for (int w = 0; w < pool.size(); w++)
+                channels[w].reset(new ResultsChannel(*results));
+        }
+
+          // Built-in players held by value play through simulateStatic,
+          // which needs no sink, budget or phase timing
+        BuiltinPlayer probe;
+        bool builtin = cfg.staticDispatch && cfg.moveMs <= 0 && cfg.gameMs <= 0 &&
+                       log == nullptr && results == nullptr &&
+                       makeBuiltinPlayer(probe, cfg.type1, cfg.type1, *games[0]) &&
+                       makeBuiltinPlayer(probe, cfg.type2, cfg.type2, *games[0]);
+
+        Timer timer;
+        pool.parallelFor(cfg.games, 64, [&](int w, long begin, long end) {
+            Game& g = *games[w];
+            Tally& t = tallies[w];
+            GameSink* sink = recorders[w].get();
+            ResultsChannel* channel = channels[w].get();
+            BuiltinPlayer builtins[2];
+            for (long k = begin; k < end; k++)
+            {
+                unique_ptr<Player> a, b;
+                if (builtin)
+                {
+                    makeBuiltinPlayer(builtins[0], cfg.type1, cfg.type1 + " 1", g);
+                    makeBuiltinPlayer(builtins[1], cfg.type2, cfg.type2 + " 2", g);
+                }
+                else
+                {
+                    a.reset(createPlayer(cfg.type1, cfg.type1 + " 1", g));
+                    b.reset(createPlayer(cfg.type2, cfg.type2 + " 2", g));
+                }
+                g.setSeed(cfg.seed, k);
+                  // Contestant 0 moves first in even-numbered games
+                bool aFirst = (k % 2 == 0);
+                GameResult r;
+                if (builtin)
+                    r = aFirst ? simulateBuiltin(g, builtins[0], builtins[1])
+                               : simulateBuiltin(g, builtins[1], builtins[0]);
+                else
+                    r = aFirst ? g.simulate(a.get(), b.get(), sink, false)
+                               : g.simulate(b.get(), a.get(), sink, false);
+                t.games++;
+                if (channel != nullptr)
+                    channel->add(makeGameRecord(k, aFirst ? 0 : 1, r));
+                if (r.winner == nullptr)
+                {
+                    t.failed++;
+                    continue;
+                }
+                t.wins[r.winnerIndex == (aFirst ? 0 : 1) ? 0 : 1]++;
+                t.shots[0] += r.shots[aFirst ? 0 : 1];
+                t.shots[1] += r.shots[aFirst ? 1 : 0];
+                t.overruns[0] += r.overruns[aFirst ? 0 : 1];
+                t.overruns[1] += r.overruns[aFirst ? 1 : 0];
+            }
+        });
+
+        if (log != nullptr)
+            log->flush();
+        if (results != nullptr)
+        {
+            channels.clear();
+            results->close();
+        }
+        double seconds = timer.elapsed() / 1000;
+        result.recordOk = (log == nullptr || log->ok());
+        result.resultsOk = (results == nullptr || results->ok());
+        return seconds;
+    }
+}
+
+TournamentResult runTournament(const TournamentConfig& cfg)
+{
+    if (cfg.cacheEntries > 0)
+        resizeSharedTranspositionCache(cfg.cacheEntries);
+    CacheStats before = sharedTranspositionCache().stats();
+    WorkStealingPool pool(cfg.threads);
+    vector<Tally> tallies(pool.size());
+    TournamentResult result;
+    BatchStrategy strategies[2];
+    if (canBatch(cfg, strategies))
+    {
+        Timer timer;
+        runBatches(cfg, strategies, pool, tallies);
+        result.seconds = timer.elapsed() / 1000;
+        result.batched = true;
+    }
+    else
+        result.seconds = playGames(cfg, pool, tallies, result);
+    for (size_t w = 0; w < tallies.size(); w++)
+    {
+        result.games += tallies[w].games;
+        result.failed += tallies[w].failed;
+        for (int s = 0; s < 2; s++)
+        {
+            result.wins[s] += tallies[w].wins[s];
+            result.shots[s] += tallies[w].shots[s];
+            result.overruns[s] += tallies[w].overruns[s];
+        }
+    }
+      // Players add their counts when they are destroyed, so all of these
+      // games' counts are in by now
+    CacheStats after = sharedTranspositionCache().stats();
+    result.cache.lookups = after.lookups - before.lookups;
+    result.cache.hits = after.hits - before.hits;
+    result.cache.stores = after.stores - before.stores;
+    result.cache.evictions = after.evictions - before.evictions;
+    result.cache.entries = after.entries;
+    return result;
+}
+
+bool addTournamentShips(Game& g, const TournamentConfig& cfg)
+{
+    return cfg.ships.empty() ? addStandardShips(g) : addShips(g, cfg.ships);
+}
@@ -0,0 +1,63 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Game.h"
+#include "TranspositionCache.h"
+
+struct TournamentConfig
+{
+    std::string type1;      // createPlayer types of the two contestants
+    std::string type2;
+    long games = 1000;
+    int threads = 1;
+    int rows = 10;
+    int cols = 10;
+    std::vector<int> ships; // ship lengths; empty for the standard fleet
+    uint64_t seed = 0;      // game k is keyed to (seed, k)
+    double moveMs = 0;      // time budgets, as for Game::setTimeBudget
+    double gameMs = 0;
+    OverrunPolicy overrunPolicy = OVERRUN_FALLBACK;
+    std::string recordPath; // if set, append every game to this replay log
+    std::string resultsPath;// if set, stream a CSV line per game to this file
+    bool batch = false;     // play on BatchEngine where both types allow it
+    bool staticDispatch = true; // hold built-in players by value (StaticGame.h)
+    size_t cacheEntries = 0;// if set, resize the shared transposition cache first
+};
+
+struct TournamentResult
+{
+    long games = 0;
+    long wins[2] = { 0, 0 };     // indexed like type1/type2
+    long shots[2] = { 0, 0 };    // total shots fired by each contestant
+    long overruns[2] = { 0, 0 }; // moves each contestant took over budget
+    long failed = 0;             // games in which a player could not place ships
+    bool recordOk = true;        // false if the replay log could not be written
+    bool resultsOk = true;       // false if the results file could not be written
+    bool batched = false;        // the games were played on BatchEngine
+    CacheStats cache;            // use of the shared transposition cache by these games
+    double seconds = 0;
+};
+
+  // Play cfg.games headless games between cfg.type1 and cfg.type2 on a
+  // work-stealing pool of cfg.threads threads, alternating who moves first.
+  // Each worker keeps its own Game, players and tallies; the tallies are
+  // merged once all games have finished.  Every game draws its randomness
+  // from (cfg.seed, game index), so the result doesn't depend on the number
+  // of threads.  Recorded games go into the replay log in the order they
+  // finish, with seat 0 the player who moved first, and so do the lines of
+  // the results file, which carry the game index.  With cfg.batch, games
+  // between two types with batch strategies, and with no time budgets,
+  // recording or results file, are played on BatchEngine instead: the
+  // same alternation of seats and the same tallies, from different draws.
+  // Otherwise, when both types are built-in players (BuiltinPlayers.h) and
+  // nothing is recorded, timed or budgeted, games go through
+  // simulateStatic, which plays exactly the games Game::simulate would.
+TournamentResult runTournament(const TournamentConfig& cfg);
+
+  // Add cfg's fleet to g
+bool addTournamentShips(Game& g, const TournamentConfig& cfg);
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,115 @@
+#include "TranspositionCache.h"
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+    mutex sharedMutex;
+    unique_ptr<TranspositionCache> sharedCache;
+      // sharedCache once made, so that finding it takes no lock
+    atomic<TranspositionCache*> publishedCache(nullptr);
+}
+
+TranspositionCache::TranspositionCache(size_t entries)
+ : m_lookups(0), m_hits(0), m_stores(0), m_evictions(0)
+{
+    size_t n = 1;
+    while (n < entries)
+        n *= 2;
+    m_entries.reset(new Entry[n]);
+    for (size_t i = 0; i < n; i++)
+    {
+        m_entries[i].check.store(0, memory_order_relaxed);
+        for (int w = 0; w < 3; w++)
+            m_entries[i].data[w].store(0, memory_order_relaxed);
+    }
+    m_mask = n - 1;
+}
+
+int TranspositionCache::lookup(uint64_t hash, int cells[MAX_CELLS]) const
+{
+    const Entry& e = m_entries[hash & m_mask];
+    uint64_t data[3];
+    for (int w = 0; w < 3; w++)
+        data[w] = e.data[w].load(memory_order_relaxed);
+    if ((e.check.load(memory_order_relaxed) ^ data[0] ^ data[1] ^ data[2]) != hash)
+        return -1;
+      // Field 0 is the count; an empty slot has none
+    int n = int(data[0] & 0xffff);
+    if (n == 0 || n > MAX_CELLS)
+        return -1;
+    for (int k = 0; k < n; k++)
+    {
+        int field = k + 1;
+        cells[k] = int((data[field / 4] >> (16 * (field % 4))) & 0xffff);
+    }
+    return n;
+}
+
+bool TranspositionCache::store(uint64_t hash, const int* cells, int n)
+{
+    if (n < 1 || n > MAX_CELLS)
+        return false;
+    uint64_t data[3] = { uint64_t(n), 0, 0 };
+    for (int k = 0; k < n; k++)
+    {
+        if (cells[k] < 0 || cells[k] >= CELL_LIMIT)
+            return false;
+        int field = k + 1;
+        data[field / 4] |= uint64_t(cells[k]) << (16 * (field % 4));
+    }
+    Entry& e = m_entries[hash & m_mask];
+    uint64_t old = e.check.load(memory_order_relaxed);
+    for (int w = 0; w < 3; w++)
+        old ^= e.data[w].load(memory_order_relaxed);
+    bool evicted = (old != hash && (e.data[0].load(memory_order_relaxed) & 0xffff) != 0);
+    e.check.store(hash ^ data[0] ^ data[1] ^ data[2], memory_order_relaxed);
+    for (int w = 0; w < 3; w++)
+        e.data[w].store(data[w], memory_order_relaxed);
+    return evicted;
+}
+
+void TranspositionCache::addCounts(long lookups, long hits, long stores, long evictions)
+{
+    m_lookups.fetch_add(lookups, memory_order_relaxed);
+    m_hits.fetch_add(hits, memory_order_relaxed);
+    m_stores.fetch_add(stores, memory_order_relaxed);
+    m_evictions.fetch_add(evictions, memory_order_relaxed);
+}
+
+CacheStats TranspositionCache::stats() const
+{
+    CacheStats s;
+    s.lookups = m_lookups.load(memory_order_relaxed);
+    s.hits = m_hits.load(memory_order_relaxed);
+    s.stores = m_stores.load(memory_order_relaxed);
+    s.evictions = m_evictions.load(memory_order_relaxed);
+    s.entries = size();
+    return s;
+}
+
+//******************** Shared cache **********************************
+
+  // Every player takes the cache when it is made, so after the first the
+  // lookup is one atomic load; only making the cache takes the lock
+TranspositionCache& sharedTranspositionCache()
+{
+    TranspositionCache* cache = publishedCache.load(memory_order_acquire);
+    if (cache != nullptr)
+        return *cache;
+    lock_guard<mutex> lock(sharedMutex);
+    if (!sharedCache)
+    {
+        sharedCache.reset(new TranspositionCache(DEFAULT_CACHE_ENTRIES));
+        publishedCache.store(sharedCache.get(), memory_order_release);
+    }
+    return *sharedCache;
+}
+
+void resizeSharedTranspositionCache(size_t entries)
+{
+    lock_guard<mutex> lock(sharedMutex);
+    sharedCache.reset(new TranspositionCache(entries));
+    publishedCache.store(sharedCache.get(), memory_order_release);
+}
@@ -0,0 +1,73 @@
+#ifndef TRANSPOSITIONCACHE_INCLUDED
+#define TRANSPOSITIONCACHE_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+struct CacheStats
+{
+    long lookups = 0;
+    long hits = 0;
+    long stores = 0;
+    long evictions = 0;     // stores that replaced another state's entry
+    size_t entries = 0;
+};
+
+  // A fixed-size table from a knowledge-state hash to the cells a strategy
+  // found best in that state.  Any number of threads may look up and store
+  // at once without locks: an entry is four words written and read one at
+  // a time, and its first word is the hash xored with the other three, so
+  // a lookup that races a store sees a mismatch and misses instead of
+  // returning a torn entry.  Each hash has one slot, and a store simply
+  // replaces what was there.
+  //
+  // The counters are not updated per call, which would make every thread
+  // write the same cache line; callers count their own lookups and add
+  // them in once, e.g. when a player is destroyed.
+class TranspositionCache
+{
+  public:
+      // Best cells kept per entry; states with more are not cached
+    static const int MAX_CELLS = 11;
+      // Cells must be below this to be stored
+    static const int CELL_LIMIT = 65536;
+
+      // entries is rounded up to a power of two
+    explicit TranspositionCache(size_t entries);
+    size_t size() const { return m_mask + 1; }
+      // Copy the cells stored for hash into cells and return how many
+      // there are, or -1 if none are stored
+    int lookup(uint64_t hash, int cells[MAX_CELLS]) const;
+      // Store n cells for hash, unless they don't fit; returns whether
+      // another state's entry was replaced
+    bool store(uint64_t hash, const int* cells, int n);
+    void addCounts(long lookups, long hits, long stores, long evictions);
+    CacheStats stats() const;
+    TranspositionCache(const TranspositionCache&) = delete;
+    TranspositionCache& operator=(const TranspositionCache&) = delete;
+
+  private:
+    struct Entry
+    {
+        std::atomic<uint64_t> check;    // hash ^ data[0] ^ data[1] ^ data[2]
+        std::atomic<uint64_t> data[3];  // 16-bit fields: the count, then the cells
+    };
+    std::unique_ptr<Entry[]> m_entries;
+    size_t m_mask;
+    std::atomic<long> m_lookups;
+    std::atomic<long> m_hits;
+    std::atomic<long> m_stores;
+    std::atomic<long> m_evictions;
+};
+
+  // The cache shared by every player in the process, with
+  // DEFAULT_CACHE_ENTRIES entries unless resized
+const size_t DEFAULT_CACHE_ENTRIES = size_t(1) << 16;
+TranspositionCache& sharedTranspositionCache();
+  // Replace the shared cache with an empty one of the given size.  Only
+  // call this while no player exists, since players hold on to the cache.
+void resizeSharedTranspositionCache(size_t entries);
+
+#endif // TRANSPOSITIONCACHE_INCLUDED
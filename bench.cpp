@@ -0,0 +1,579 @@
+#include "Benchmark.h"
+#include "FixedGame.h"
+#include "Game.h"
+#include "GameSink.h"
+#include "Board.h"
+#include "Player.h"
+#include "FleetGenerator.h"
+#include "Tournament.h"
+#include "BatchEngine.h"
+#include "StaticGame.h"
+#include "Solver.h"
+#include "AsyncGame.h"
+#include "ShotSelector.h"
+#include "Strategies.h"
+#include "globals.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace
+{
+    const uint64_t SEED = 1;
+    const char* const AI_TYPES[] = { "awful", "mediocre", "good", "density", "montecarlo" };
+
+      // The dynamic twin of FixedRandomPlayer: the same policy, played
+      // through Game, Board and the virtual Player interface
+    class RandomPlayer : public Player
+    {
+      public:
+        RandomPlayer(string nm, const Game& g) : Player(nm, g), m_left(0) {}
+
+        virtual bool placeShips(Board& b)
+        {
+            FleetGenerator gen(game());
+            m_left = game().rows() * game().cols();
+            m_cells.resize(m_left);
+            for (int i = 0; i < m_left; i++)
+                m_cells[i] = i;
+            return gen.placeFleet(b, rng());
+        }
+        virtual Point recommendAttack()
+        {
+            int k = rng().below(m_left);
+            int cell = m_cells[k];
+            m_cells[k] = m_cells[--m_left];
+            return Point(cell / game().cols(), cell % game().cols());
+        }
+        virtual void recordAttackResult(Point /* p */, bool /* validShot */, bool /* shotHit */,
+                                        bool /* shipDestroyed */, int /* shipId */)
+        {}
+        virtual void recordAttackByOpponent(Point /* p */) {}
+
+      private:
+        vector<int> m_cells;
+        int m_left;
+    };
+
+    string shape(int rows, int cols)
+    {
+        return to_string(rows) + "x" + to_string(cols);
+    }
+
+      // A game of the given shape with the standard fleet
+    shared_ptr<Game> standardGame(int rows, int cols)
+    {
+        shared_ptr<Game> g(new Game(rows, cols));
+        addStandardShips(*g);
+        return g;
+    }
+
+      // Random legal layouts of a game's fleet, generated ahead of time so
+      // the board benchmarks time only the board
+    shared_ptr<vector<vector<ShipPlacement>>> layouts(const Game& g, int n)
+    {
+        shared_ptr<vector<vector<ShipPlacement>>> all(new vector<vector<ShipPlacement>>(n));
+        FleetGenerator gen(g);
+        RandomStream rs(SEED, 0, BOARD1_STREAM);
+        for (vector<ShipPlacement>& layout : *all)
+            gen.generate(rs, layout);
+        return all;
+    }
+
+    void addBoardBenchmarks(BenchmarkSuite& suite, int rows, int cols)
+    {
+        const int BOARDS = 64;
+        shared_ptr<Game> g = standardGame(rows, cols);
+        shared_ptr<vector<vector<ShipPlacement>>> fleets = layouts(*g, BOARDS);
+          // The boards keep a reference to their game, so they share it
+        struct BoardSet
+        {
+            shared_ptr<Game> g;
+            vector<unique_ptr<Board>> boards;
+        };
+        shared_ptr<BoardSet> set(new BoardSet);
+        set->g = g;
+        for (int k = 0; k < BOARDS; k++)
+            set->boards.emplace_back(new Board(*g));
+        shared_ptr<vector<unique_ptr<Board>>> boards(set, &set->boards);
+          // Every cell in a random order, the same for every board
+        shared_ptr<vector<Point>> cells(new vector<Point>);
+        RandomStream rs(SEED, 0, PLAYER1_STREAM);
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+                cells->push_back(Point(r, c));
+        for (size_t k = cells->size(); k > 1; k--)
+            swap((*cells)[k - 1], (*cells)[rs.below(k)]);
+
+        auto clearAll = [boards]() {
+            for (unique_ptr<Board>& b : *boards)
+                b->clear();
+        };
+        auto placeAll = [boards, fleets]() {
+            long placed = 0;
+            for (size_t k = 0; k < boards->size(); k++)
+            {
+                const vector<ShipPlacement>& layout = (*fleets)[k];
+                for (size_t s = 0; s < layout.size(); s++)
+                    placed += (*boards)[k]->placeShip(layout[s].topOrLeft, s, layout[s].dir);
+            }
+            return placed;
+        };
+        string size = shape(rows, cols);
+
+        suite.add("board/placeShip/" + size, "placements", placeAll, clearAll);
+        suite.add("board/attack/" + size, "attacks", [boards, cells]() {
+            long n = 0;
+            bool hit, destroyed;
+            int shipId;
+            for (unique_ptr<Board>& b : *boards)
+                for (const Point& p : *cells)
+                    n += b->attack(p, hit, destroyed, shipId);
+            return n;
+        }, [clearAll, placeAll]() { clearAll(); placeAll(); });
+        suite.add("board/allShipsDestroyed/" + size, "calls", [boards]() {
+            const int CALLS = 1000;
+            long sunk = 0;
+            for (int k = 0; k < CALLS; k++)
+                for (unique_ptr<Board>& b : *boards)
+                    sunk += b->allShipsDestroyed();
+              // Keep the calls from being optimized away
+            return sunk >= 0 ? long(CALLS) * boards->size() : 0;
+        }, [clearAll, placeAll]() { clearAll(); placeAll(); });
+    }
+
+      // recommendAttack and recordAttackResult for one player shooting at a
+      // placed board until the fleet is sunk
+    void addMoveBenchmark(BenchmarkSuite& suite, const string& type, int rows, int cols)
+    {
+        struct State
+        {
+            shared_ptr<Game> g;
+            unique_ptr<Board> target;
+            unique_ptr<Player> p;
+            long round = 0;
+        };
+        shared_ptr<State> st(new State);
+        st->g = standardGame(rows, cols);
+          // A type that falls back to a lighter strategy on this board would
+          // be timed under the wrong name
+        if (playingType(type, *st->g) != type)
+            return;
+        st->target.reset(new Board(*st->g));
+        suite.add("move/" + type + "/" + shape(rows, cols), "moves", [st]() {
+            long moves = 0;
+            long limit = 2L * st->g->rows() * st->g->cols();
+            bool hit, destroyed;
+            int shipId;
+            while (!st->target->allShipsDestroyed() && moves < limit)
+            {
+                Point p = st->p->recommendAttack();
+                bool valid = st->target->attack(p, hit, destroyed, shipId);
+                st->p->recordAttackResult(p, valid, hit, destroyed, shipId);
+                moves++;
+            }
+            return moves;
+        }, [st, type]() {
+            st->p.reset(createPlayer(type, type, *st->g));
+            st->p->setRandomStream(RandomStream(SEED, st->round, PLAYER1_STREAM));
+            RandomStream rs(SEED, st->round, BOARD1_STREAM);
+            st->round++;
+            st->target->clear();
+            FleetGenerator(*st->g).placeFleet(*st->target, rs);
+        });
+    }
+
+      // Whole headless games through Game::simulate
+    void addGameBenchmark(BenchmarkSuite& suite, const string& type1, const string& type2,
+                          int rows, int cols)
+    {
+        struct State
+        {
+            shared_ptr<Game> g;
+            unique_ptr<Player> p1;
+            unique_ptr<Player> p2;
+            long round = 0;
+        };
+        shared_ptr<State> st(new State);
+        st->g = standardGame(rows, cols);
+        st->p1.reset(createPlayer(type1, type1, *st->g));
+        st->p2.reset(createPlayer(type2, type2, *st->g));
+        string name = "game/" + type1 + "-" + type2 + "/" + shape(rows, cols);
+        suite.add(name, "games", [st]() {
+              // Players keep per-game state, so each round uses fresh ones
+              // built in the untimed setup
+            st->g->setSeed(SEED, st->round++);
+            st->g->simulate(st->p1.get(), st->p2.get(), nullptr, false);
+            return 1L;
+        }, [st, type1, type2]() {
+            st->p1.reset(createPlayer(type1, type1, *st->g));
+            st->p2.reset(createPlayer(type2, type2, *st->g));
+        });
+    }
+
+      // The same games as the game/ benchmark of the pairing, with the
+      // players held by value and called directly
+    void addStaticBenchmark(BenchmarkSuite& suite, const string& type1, const string& type2,
+                            int rows, int cols)
+    {
+        struct State
+        {
+            shared_ptr<Game> g;
+            BuiltinPlayer p1;
+            BuiltinPlayer p2;
+            long round = 0;
+        };
+        shared_ptr<State> st(new State);
+        st->g = standardGame(rows, cols);
+        if (!makeBuiltinPlayer(st->p1, type1, type1, *st->g) ||
+            !makeBuiltinPlayer(st->p2, type2, type2, *st->g))
+            return;
+        suite.add("static/" + type1 + "-" + type2 + "/" + shape(rows, cols), "games", [st]() {
+            st->g->setSeed(SEED, st->round++);
+            simulateBuiltin(*st->g, st->p1, st->p2);
+            return 1L;
+        }, [st, type1, type2]() {
+            makeBuiltinPlayer(st->p1, type1, type1, *st->g);
+            makeBuiltinPlayer(st->p2, type2, type2, *st->g);
+        });
+    }
+
+      // For each static/ result, its rate over that of the matching game/
+      // result
+    void reportStaticGains(const vector<BenchmarkResult>& results, ostream& out)
+    {
+        bool header = false;
+        for (const BenchmarkResult& s : results)
+        {
+            if (s.name.compare(0, 7, "static/") != 0)
+                continue;
+            string name = "game/" + s.name.substr(7);
+            for (const BenchmarkResult& d : results)
+            {
+                if (d.name != name || d.rate <= 0)
+                    continue;
+                if (!header)
+                {
+                    out << "\nStatic over virtual dispatch:\n";
+                    header = true;
+                }
+                out << "  " << left << setw(38) << s.name.substr(7) << right << fixed
+                    << setprecision(2) << s.rate / d.rate << "x" << defaultfloat << '\n';
+            }
+        }
+    }
+
+      // Whole games on BatchEngine, to compare with the game/ benchmark of
+      // the same pairing
+    void addBatchBenchmark(BenchmarkSuite& suite, const string& type1, const string& type2,
+                           int rows, int cols)
+    {
+        const long GAMES = 4096;
+        BatchStrategy s1, s2;
+        if (!batchStrategy(type1, s1) || !batchStrategy(type2, s2))
+            return;
+        shared_ptr<Game> g = standardGame(rows, cols);
+        shared_ptr<BatchEngine> engine(new BatchEngine(*g, s1, s2));
+        shared_ptr<long> round(new long(0));
+          // The engine refers to the game, so the body keeps it alive
+        suite.add("batch/" + type1 + "-" + type2 + "/" + shape(rows, cols), "games",
+                  [g, engine, round]() {
+            BatchResult r;
+            engine->run(SEED, *round, GAMES, 1, r);
+            *round += GAMES;
+            return GAMES;
+        });
+    }
+
+      // The same games as the game/ benchmark of the pairing, each one a
+      // coroutine run on a Scheduler; playAsync calls computer players
+      // inline, so the difference is the cost of the coroutine frame
+    void addAsyncBenchmark(BenchmarkSuite& suite, const string& type1, const string& type2,
+                           int rows, int cols)
+    {
+        struct State
+        {
+            shared_ptr<Game> g;
+            unique_ptr<Player> p1;
+            unique_ptr<Player> p2;
+            long round = 0;
+        };
+        shared_ptr<State> st(new State);
+        st->g = standardGame(rows, cols);
+        suite.add("async/" + type1 + "-" + type2 + "/" + shape(rows, cols), "games", [st]() {
+            Scheduler s;
+            Task<GameResult> game = playAsync(*st->g, st->p1.get(), st->p2.get(), SEED, st->round++);
+            s.start(game);
+            s.runReady();
+            return 1L;
+        }, [st, type1, type2]() {
+            st->p1.reset(createPlayer(type1, type1, *st->g));
+            st->p2.reset(createPlayer(type2, type2, *st->g));
+        });
+    }
+
+      // games games at once on one thread, each between a RemotePlayer and
+      // a good player.  The loop driving the scheduler answers each remote
+      // player that is waiting with a random layout or untried cell, as a
+      // server would pass on moves read from its clients.
+    void addMultiplexBenchmark(BenchmarkSuite& suite, long games)
+    {
+        shared_ptr<Game> g = standardGame(10, 10);
+        shared_ptr<long> round(new long(0));
+        suite.add("async/remote-good/10x10/" + to_string(games) + "-at-once", "games",
+                  [g, games, round]() {
+            Scheduler s;
+            FleetGenerator gen(*g);
+            RandomStream rs(SEED, *round, GAME_STREAM);
+            vector<unique_ptr<RemotePlayer>> remotes;
+            vector<unique_ptr<Player>> ais;
+            vector<unique_ptr<CellPool>> untried;
+            vector<Task<GameResult>> tasks;
+            tasks.reserve(games);
+            for (long k = 0; k < games; k++)
+            {
+                remotes.emplace_back(new RemotePlayer("remote", *g));
+                ais.emplace_back(createPlayer("good", "good", *g));
+                untried.emplace_back(new CellPool(g->rows(), g->cols()));
+                tasks.push_back(playAsync(*g, remotes[k].get(), ais[k].get(), SEED,
+                                          *round * games + k));
+                s.start(tasks[k]);
+            }
+            long left = games;
+            vector<ShipPlacement> layout;
+            while (left > 0)
+            {
+                s.runReady();
+                left = 0;
+                for (long k = 0; k < games; k++)
+                {
+                    if (tasks[k].done())
+                        continue;
+                    left++;
+                    if (remotes[k]->wantsPlacement() && gen.generate(rs, layout))
+                        remotes[k]->sendPlacement(layout);
+                    else if (remotes[k]->wantsAttack())
+                        remotes[k]->sendAttack(untried[k]->drawPoint(rs));
+                }
+            }
+            ++*round;
+            return games;
+        });
+    }
+
+      // Solving a small configuration from scratch on every core; the rate
+      // is knowledge states solved per second
+    void addSolverBenchmark(BenchmarkSuite& suite, int rows, int cols, const vector<int>& ships)
+    {
+        shared_ptr<Game> g(new Game(rows, cols));
+        if (!addShips(*g, ships))
+            return;
+        string name = "solver/" + shape(rows, cols);
+        for (size_t k = 0; k < ships.size(); k++)
+            name += (k == 0 ? "/" : "-") + to_string(ships[k]);
+        int threads = max(1, int(thread::hardware_concurrency()));
+        suite.add(name, "states", [g, threads]() {
+            OptimalSolver solver(*g);
+            solver.solve(threads);
+            return solver.stats().states;
+        });
+    }
+
+      // The same random-shooting policy on the runtime-sized and on the
+      // compile-time specialized path
+    void addFixedBenchmarks(BenchmarkSuite& suite)
+    {
+        const long GAMES = 256;
+        shared_ptr<Game> standard = standardGame(10, 10);
+        shared_ptr<Game> rowboat(new Game(2, 3));
+        rowboat->addShip(2, 'R', "rowboat");
+        for (shared_ptr<Game> g : { standard, rowboat })
+        {
+            shared_ptr<long> round(new long(0));
+            suite.add("game/random-dynamic/" + shape(g->rows(), g->cols()), "games", [g, round]() {
+                RandomPlayer p1("random 1", *g);
+                RandomPlayer p2("random 2", *g);
+                for (long k = 0; k < GAMES; k++)
+                {
+                    g->setSeed(SEED, (*round)++);
+                    g->simulate(&p1, &p2, nullptr, false);
+                }
+                return GAMES;
+            });
+        }
+          // A fixed game inlines completely, so its results are kept or the
+          // optimizer would drop the games
+        shared_ptr<long> round(new long(0));
+        suite.add("game/random-fixed/10x10", "games", [round]() {
+            StandardFixedGame game;
+            FixedRandomPlayer<10, 10> p1, p2;
+            long shots = 0;
+            for (long k = 0; k < GAMES; k++)
+            {
+                FixedResult r = game.simulate(p1, p2, SEED, (*round)++);
+                shots += r.shots[0] + r.shots[1] + r.winnerIndex;
+            }
+            keepResult(shots);
+            return GAMES;
+        });
+        suite.add("game/random-fixed/2x3", "games", [round]() {
+            RowboatFixedGame game;
+            FixedRandomPlayer<2, 3> p1, p2;
+            long shots = 0;
+            for (long k = 0; k < GAMES; k++)
+            {
+                FixedResult r = game.simulate(p1, p2, SEED, (*round)++);
+                shots += r.shots[0] + r.shots[1] + r.winnerIndex;
+            }
+            keepResult(shots);
+            return GAMES;
+        });
+    }
+
+      // Tournament throughput on a given number of threads
+    void addThreadBenchmark(BenchmarkSuite& suite, int threads)
+    {
+        suite.add("threads/mediocre-good/" + to_string(threads), "games", [threads]() {
+            TournamentConfig cfg;
+            cfg.type1 = "mediocre";
+            cfg.type2 = "good";
+            cfg.games = 2000;
+            cfg.threads = threads;
+            cfg.seed = SEED;
+            return runTournament(cfg).games;
+        });
+    }
+
+    BenchmarkSuite buildSuite(bool quick)
+    {
+        BenchmarkSuite suite;
+        vector<int> sizes = { 10, 30, 100 };
+        if (!quick)
+            sizes.push_back(300);
+
+          // Micro: board operations and single moves
+        for (int n : sizes)
+            addBoardBenchmarks(suite, n, n);
+        for (const char* type : AI_TYPES)
+            addMoveBenchmark(suite, type, 10, 10);
+
+          // Macro: whole games for every pairing
+        int nTypes = sizeof(AI_TYPES) / sizeof(AI_TYPES[0]);
+        for (int a = 0; a < nTypes; a++)
+            for (int b = a; b < nTypes; b++)
+                addGameBenchmark(suite, AI_TYPES[a], AI_TYPES[b], 10, 10);
+        for (int a = 0; a < nTypes; a++)
+            for (int b = a; b < nTypes; b++)
+                addStaticBenchmark(suite, AI_TYPES[a], AI_TYPES[b], 10, 10);
+        for (int a = 0; a < nTypes; a++)
+            for (int b = a; b < nTypes; b++)
+                addBatchBenchmark(suite, AI_TYPES[a], AI_TYPES[b], 10, 10);
+        addFixedBenchmarks(suite);
+        addAsyncBenchmark(suite, "awful", "awful", 10, 10);
+        addAsyncBenchmark(suite, "density", "good", 10, 10);
+        addMultiplexBenchmark(suite, 1000);
+        if (!quick)
+            addMultiplexBenchmark(suite, 10000);
+        addSolverBenchmark(suite, 3, 3, { 2, 2 });
+        addSolverBenchmark(suite, 3, 3, { 3, 2 });
+        if (!quick)
+            addSolverBenchmark(suite, 4, 4, { 3, 2 });
+
+          // Scaling over board size and thread count
+        for (int n : sizes)
+        {
+            if (n == 10)
+                continue;
+            addMoveBenchmark(suite, "good", n, n);
+            addMoveBenchmark(suite, "density", n, n);
+            addGameBenchmark(suite, "mediocre", "good", n, n);
+        }
+        int hw = max(1, int(thread::hardware_concurrency()));
+        for (int t = 1; t < hw; t *= 2)
+            addThreadBenchmark(suite, t);
+        addThreadBenchmark(suite, hw);
+        return suite;
+    }
+
+    void usage(const char* prog)
+    {
+        cerr << "usage: " << prog << " [--quick] [--filter text] [--min-time seconds]\n"
+             << "       [--csv file] [--json file] [--baseline file] [--tolerance fraction]" << endl;
+    }
+}
+
+  // Runs the benchmark suite.  Results go to the console, and optionally to
+  // CSV or JSON files; with --baseline, each result is compared with the
+  // rate recorded in an earlier CSV, and the exit status is 2 if any of
+  // them fell more than the tolerance below it.
+int main(int argc, char* argv[])
+{
+    bool quick = false;
+    string filter, csvPath, jsonPath, baselinePath;
+    double minSeconds = 0.2;
+    double tolerance = 0.2;
+    for (int k = 1; k < argc; k++)
+    {
+        string arg = argv[k];
+        bool hasValue = (k + 1 < argc);
+        if (arg == "--quick")
+            quick = true;
+        else if (arg == "--filter" && hasValue)
+            filter = argv[++k];
+        else if (arg == "--min-time" && hasValue)
+            minSeconds = atof(argv[++k]);
+        else if (arg == "--csv" && hasValue)
+            csvPath = argv[++k];
+        else if (arg == "--json" && hasValue)
+            jsonPath = argv[++k];
+        else if (arg == "--baseline" && hasValue)
+            baselinePath = argv[++k];
+        else if (arg == "--tolerance" && hasValue)
+            tolerance = atof(argv[++k]);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (quick && minSeconds > 0.05)
+        minSeconds = 0.05;
+
+    vector<BenchmarkResult> baseline;
+    if (!baselinePath.empty() && !readCsv(baselinePath, baseline))
+    {
+        cerr << "Cannot read baseline " << baselinePath << endl;
+        return 1;
+    }
+
+    vector<BenchmarkResult> results = buildSuite(quick).run(filter, minSeconds, cout);
+    reportStaticGains(results, cout);
+    if (!csvPath.empty() && !writeCsv(results, csvPath))
+    {
+        cerr << "Cannot write " << csvPath << endl;
+        return 1;
+    }
+    if (!jsonPath.empty() && !writeJson(results, jsonPath))
+    {
+        cerr << "Cannot write " << jsonPath << endl;
+        return 1;
+    }
+    if (!baselinePath.empty())
+    {
+        cout << "\nCompared with " << baselinePath << ":\n";
+        int regressions = compareWithBaseline(results, baseline, tolerance, cout);
+        if (regressions > 0)
+        {
+            cout << regressions << " benchmark(s) regressed by more than "
+                 << tolerance * 100 << "%" << endl;
+            return 2;
+        }
+    }
+}
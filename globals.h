@@ -1,10 +1,12 @@
 #ifndef GLOBALS_INCLUDED
 #define GLOBALS_INCLUDED
 
-#include <random>
+#include "Random.h"
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+  // Boards of up to 128 cells use bitboards; larger ones, up to these
+  // limits, use the sparse board and sparse player knowledge
+const int MAXROWS = 1000;
+const int MAXCOLS = 1000;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,15 +21,14 @@ class Point
     int c;
 };
 
-  // Return a uniformly distributed random int from 0 to limit-1
+  // Return a uniformly distributed random int from 0 to limit-1.  This
+  // draws from an unseeded per-thread stream; game code draws from the
+  // RandomStream of its Game, Board or Player instead so that a seeded game
+  // is reproducible.
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
-    if (limit < 1)
-        limit = 1;
-    std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    static thread_local RandomStream stream;
+    return stream.below(limit);
 }
 
 #endif // GLOBALS_INCLUDED
@@ -6,18 +6,15 @@
 
 using namespace std;
 
-bool addStandardShips(Game& g)
-{
-    return g.addShip(5, 'A', "aircraft carrier")  &&
-           g.addShip(4, 'B', "battleship")  &&
-           g.addShip(3, 'D', "destroyer")  &&
-           g.addShip(3, 'S', "submarine")  &&
-           g.addShip(2, 'P', "patrol boat");
-}
-
-int main()
+  // usage: battleship [--ansi]
+  // --ansi shows both boards side by side and redraws them in place, for
+  // terminals that understand ANSI cursor movement
+int main(int argc, char* argv[])
 {
     const int NTRIALS = 10;
+    DisplayMode mode = DISPLAY_PLAIN;
+    if (argc > 1 && string(argv[1]) == "--ansi")
+        mode = DISPLAY_ANSI;
 
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
@@ -35,6 +32,7 @@ int main()
     else if (line[0] == '1')
     {
         Game g(2, 3);
+        g.setDisplayMode(mode);
         g.addShip(2, 'R', "rowboat");
         Player* p1 = createPlayer("mediocre", "Popeye", g);
         Player* p2 = createPlayer("mediocre", "Bluto", g);
@@ -46,6 +44,7 @@ int main()
     else if (line[0] == '2')
     {
         Game g(10, 10);
+        g.setDisplayMode(mode);
         addStandardShips(g);
         Player* p1 = createPlayer("mediocre", "Mediocre Midori", g);
         Player* p2 = createPlayer("human", "Shuman the Human", g);
@@ -62,6 +61,7 @@ int main()
             cout << "============================= Game " << k
                  << " =============================" << endl;
             Game g(10, 10);
+            g.setDisplayMode(mode);
             addStandardShips(g);
             Player* p1 = createPlayer("mediocre", "mediocre player", g);
             Player* p2 = createPlayer("good", "good player", g);
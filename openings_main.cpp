@@ -0,0 +1,48 @@
+#include "OpeningBook.h"
+#include "Game.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+  // usage: openings book [rows cols]...
+  // Computes the opening line of the standard fleet on each board size
+  // given (10x10 if none is) and adds it to a book file, creating the file
+  // if need be.  Lines already in the book are recomputed.
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc % 2 != 0)
+    {
+        cerr << "usage: " << argv[0] << " book [rows cols]..." << endl;
+        return 1;
+    }
+    string path = argv[1];
+    vector<pair<int, int>> sizes;
+    for (int k = 2; k + 1 < argc; k += 2)
+        sizes.push_back(make_pair(atoi(argv[k]), atoi(argv[k + 1])));
+    if (sizes.empty())
+        sizes.push_back(make_pair(10, 10));
+
+    OpeningBook book;
+    if (!book.load(path))
+        cout << "Starting a new book " << path << '\n';
+    for (size_t k = 0; k < sizes.size(); k++)
+    {
+        Game g(sizes[k].first, sizes[k].second);
+        if (!addStandardShips(g))
+            return 1;
+        vector<int> line = computeOpening(g);
+        book.add(g, line);
+        cout << g.rows() << "x" << g.cols() << ":";
+        for (size_t s = 0; s < line.size(); s++)
+            cout << " (" << line[s] / g.cols() << "," << line[s] % g.cols() << ")";
+        cout << '\n';
+    }
+    if (!book.save(path))
+    {
+        cerr << "Cannot write " << path << endl;
+        return 1;
+    }
+}
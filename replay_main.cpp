@@ -0,0 +1,85 @@
+#include "ReplayLog.h"
+#include "Game.h"
+#include "Board.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <memory>
+
+using namespace std;
+
+  // usage: replay log [game [turn]]
+  // With just a log, prints how many games it holds and how often each seat
+  // won.  With a game number, prints that game's outcome and both boards as
+  // they stood after the given number of shots (by default, at the end).
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        cerr << "usage: " << argv[0] << " log [game [turn]]" << endl;
+        return 1;
+    }
+    ReplayReader reader(argv[1]);
+    if (!reader.ok())
+    {
+        cerr << "Cannot open replay log " << argv[1] << endl;
+        return 1;
+    }
+
+    ReplayGame rg;
+    if (argc == 2)
+    {
+        long wins[2] = { 0, 0 };
+        for (long n = 0; n < reader.games(); n++)
+        {
+            if (!reader.readGame(n, rg))
+            {
+                cerr << "Game " << n << " is damaged" << endl;
+                return 1;
+            }
+            wins[rg.winnerIndex]++;
+        }
+        cout << reader.games() << " games; the first mover won " << wins[0]
+             << ", the second " << wins[1] << '\n';
+        return 0;
+    }
+
+    long n = atol(argv[2]);
+    if (!reader.readGame(n, rg))
+    {
+        cerr << "The log has no game " << n << " (it has " << reader.games() << ")" << endl;
+        return 1;
+    }
+    long turns = (argc > 3 ? atol(argv[3]) : long(rg.shots.size()));
+    if (turns < 0 || turns > long(rg.shots.size()))
+        turns = long(rg.shots.size());
+    unique_ptr<Game> g = makeReplayGame(rg.config);
+    Board b1(*g);
+    Board b2(*g);
+    if (!replayBoards(rg, turns, b1, b2))
+    {
+        cerr << "Game " << n << " does not replay consistently" << endl;
+        return 1;
+    }
+
+    cout << "Game " << n << " on a " << rg.config.rows << "x" << rg.config.cols
+         << " board: seat " << rg.winnerIndex + 1 << " won in " << rg.shots.size()
+         << " shots" << '\n';
+    if (rg.hasSeed)
+        cout << "Played as game " << rg.gameIndex << " of seed " << rg.seed << '\n';
+    if (turns > 0)
+    {
+        const ShotEvent& e = rg.shots[turns - 1];
+        cout << "Shot " << turns << ": seat " << e.shooter + 1 << " ";
+        if (!e.validShot)
+            cout << "wasted a shot";
+        else
+            cout << (e.shipDestroyed ? "sank a ship" : e.shotHit ? "hit" : "missed")
+                 << " at (" << e.p.r << "," << e.p.c << ")";
+        cout << '\n';
+    }
+    cout << "Board of seat 1:" << endl;
+    b1.display(false);
+    cout << "Board of seat 2:" << endl;
+    b2.display(false);
+}
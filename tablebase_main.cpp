@@ -0,0 +1,87 @@
+#include "Tablebase.h"
+#include "Solver.h"
+#include "Game.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+      // Parse "RxC" and comma-separated ship lengths
+    bool parseConfig(const string& board, const string& ships, int& rows, int& cols,
+                     vector<int>& lengths)
+    {
+        istringstream in(board);
+        char x;
+        if (!(in >> rows >> x >> cols) || x != 'x' || rows < 1 || cols < 1)
+            return false;
+        istringstream list(ships);
+        string len;
+        lengths.clear();
+        while (getline(list, len, ','))
+        {
+            lengths.push_back(atoi(len.c_str()));
+            if (lengths.back() < 1)
+                return false;
+        }
+        return !lengths.empty();
+    }
+}
+
+  // usage: tablebase file RxC l1,l2,... [RxC l1,l2,...]...
+  // Solves each configuration given, a board size and the lengths of its
+  // ships, with a thread per core and adds its solved states to a
+  // tablebase file, creating the file if need be.  Configurations already
+  // in the file are solved again.  Open the file with tournament
+  // --tablebase.
+int main(int argc, char* argv[])
+{
+    if (argc < 4 || argc % 2 != 0)
+    {
+        cerr << "usage: " << argv[0] << " file RxC l1,l2,... [RxC l1,l2,...]..." << endl;
+        return 1;
+    }
+    string path = argv[1];
+    Tablebase base;
+    if (!base.open(path))
+        cout << "Starting a new tablebase " << path << '\n';
+    int threads = max(1, int(thread::hardware_concurrency()));
+    for (int k = 2; k + 1 < argc; k += 2)
+    {
+        int rows, cols;
+        vector<int> lengths;
+        if (!parseConfig(argv[k], argv[k + 1], rows, cols, lengths))
+        {
+            cerr << "Cannot read configuration " << argv[k] << " " << argv[k + 1] << endl;
+            return 1;
+        }
+        Game g(rows, cols);
+        if (!addShips(g, lengths))
+        {
+            cerr << "The fleet " << argv[k + 1] << " does not fit on " << argv[k] << endl;
+            return 1;
+        }
+        OptimalSolver solver(g);
+        if (!solver.fits() || !solver.solve(threads))
+        {
+            cerr << argv[k] << " " << argv[k + 1] << " is too big to solve" << endl;
+            return 1;
+        }
+        const SolverStats& st = solver.stats();
+        cout << argv[k] << " " << argv[k + 1] << ": " << st.layouts << " layouts, "
+             << st.states << " states in " << st.seconds << " s, "
+             << st.expectedShots << " expected shots" << '\n';
+        base.add(g, solver);
+    }
+    if (!base.write(path))
+    {
+        cerr << "Cannot write " << path << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,227 @@
+#include "ReplayLog.h"
+#include "Tablebase.h"
+#include "Solver.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "GameSink.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cmath>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool ok, const string& what)
+    {
+        if (!ok)
+        {
+            cout << "FAILED: " << what << endl;
+            failures++;
+        }
+    }
+
+    string scratchPath(const string& name)
+    {
+        return "/tmp/bsim_check_" + to_string(getpid()) + "_" + name;
+    }
+
+      // A recorder that also keeps where each seat's ships went, to compare
+      // with what the log gives back
+    class FleetKeeper : public ReplayRecorder
+    {
+      public:
+        FleetKeeper(ReplayLog& log, const Game& g) : ReplayRecorder(log, g), m_game(g) {}
+        void shipsPlaced(const Board& b1, const Board& b2)
+        {
+            const Board* boards[2] = { &b1, &b2 };
+            for (int s = 0; s < 2; s++)
+            {
+                fleets[s].resize(m_game.nShips());
+                for (int k = 0; k < m_game.nShips(); k++)
+                    boards[s]->shipPlacement(k, fleets[s][k].topOrLeft, fleets[s][k].dir);
+            }
+            ReplayRecorder::shipsPlaced(b1, b2);
+        }
+        vector<ShipPlacement> fleets[2];
+
+      private:
+        const Game& m_game;
+    };
+
+    struct PlayedGame
+    {
+        GameResult result;
+        vector<ShipPlacement> fleets[2];
+    };
+
+      // Games written to a log read back with the same configuration,
+      // fleets, shots, winner, seed and game index
+    void testReplayRoundTrip()
+    {
+        const uint64_t seed = 12345;
+        const int nGames = 20;
+        string path = scratchPath("replay.log");
+        Game g(6, 7);
+        addShips(g, { 4, 3, 2 });
+        vector<PlayedGame> played(nGames);
+        {
+            ReplayLog log(g, path);
+            check(log.ok(), "replay log opens for writing");
+            FleetKeeper keeper(log, g);
+            for (int k = 0; k < nGames; k++)
+            {
+                unique_ptr<Player> p1(createPlayer("good", "first", g));
+                unique_ptr<Player> p2(createPlayer("mediocre", "second", g));
+                g.setSeed(seed, k);
+                played[k].result = g.simulate(p1.get(), p2.get(), &keeper, true);
+                played[k].fleets[0] = keeper.fleets[0];
+                played[k].fleets[1] = keeper.fleets[1];
+            }
+            log.flush();
+            check(log.ok() && log.games() == nGames, "replay log holds every game");
+        }
+
+        ReplayReader reader(path);
+        check(reader.ok() && reader.games() == nGames, "replay log reads back every game");
+        for (int k = 0; reader.ok() && k < nGames; k++)
+        {
+            string game = "replay game " + to_string(k);
+            ReplayGame rg;
+            if (!reader.readGame(k, rg))
+            {
+                check(false, game + " reads");
+                continue;
+            }
+            const GameResult& r = played[k].result;
+            check(rg.config.rows == 6 && rg.config.cols == 7 && rg.config.ships.size() == 3 &&
+                  rg.config.ships[0].length == 4 && rg.config.ships[2].length == 2,
+                  game + " configuration");
+            check(rg.winnerIndex == r.winnerIndex, game + " winner");
+            check(rg.hasSeed && rg.seed == seed && rg.gameIndex == uint64_t(k),
+                  game + " seed and game index");
+            for (int s = 0; s < 2; s++)
+            {
+                bool same = rg.fleets[s].size() == played[k].fleets[s].size();
+                for (size_t i = 0; same && i < rg.fleets[s].size(); i++)
+                    same = rg.fleets[s][i].topOrLeft.r == played[k].fleets[s][i].topOrLeft.r &&
+                           rg.fleets[s][i].topOrLeft.c == played[k].fleets[s][i].topOrLeft.c &&
+                           rg.fleets[s][i].dir == played[k].fleets[s][i].dir;
+                check(same, game + " fleet of seat " + to_string(s));
+            }
+            bool same = rg.shots.size() == r.events.size();
+            for (size_t i = 0; same && i < rg.shots.size(); i++)
+            {
+                const ShotEvent& a = rg.shots[i];
+                const ShotEvent& b = r.events[i];
+                same = a.shooter == b.shooter && a.p.r == b.p.r && a.p.c == b.p.c &&
+                       a.validShot == b.validShot && a.shotHit == b.shotHit &&
+                       a.shipDestroyed == b.shipDestroyed;
+            }
+            check(same, game + " shots");
+
+            unique_ptr<Game> rgGame = makeReplayGame(rg.config);
+            Board b1(*rgGame);
+            Board b2(*rgGame);
+            check(replayBoards(rg, long(rg.shots.size()), b1, b2) &&
+                  (rg.winnerIndex == 0 ? b2 : b1).allShipsDestroyed(),
+                  game + " replays to the loser's fleet sunk");
+        }
+        remove(path.c_str());
+        remove((path + ".idx").c_str());
+    }
+
+      // A tablebase written and mapped again gives back every solved state
+    void testTablebaseRoundTrip()
+    {
+        string path = scratchPath("tablebase");
+        Game g(3, 3);
+        addShips(g, { 3, 2 });
+        OptimalSolver solver(g);
+        check(solver.solve(1), "tablebase configuration solves");
+        vector<OptimalSolver::SolvedState> states;
+        solver.solvedStates(states);
+
+        Tablebase written;
+        written.add(g, solver);
+        check(written.write(path), "tablebase writes");
+        check(!written.write(scratchPath("missing/tablebase")), "tablebase write to a bad path fails");
+        check(access((scratchPath("missing/tablebase") + ".tmp").c_str(), F_OK) != 0,
+              "failed tablebase write leaves no temporary file");
+
+        Tablebase read;
+        check(read.open(path), "tablebase opens");
+        check(read.configs() == 1 && read.states() == states.size(), "tablebase holds every state");
+        int config = read.findConfig(g);
+        check(config >= 0, "tablebase finds its configuration");
+        Game other(3, 3);
+        addShips(other, { 2, 2 });
+        check(read.findConfig(other) < 0, "tablebase misses a configuration it lacks");
+        int matched = 0;
+        for (const OptimalSolver::SolvedState& st : states)
+        {
+            Tablebase::Entry e;
+            if (read.find(config, st.key, 9, e) && e.best == st.best &&
+                e.value == float(st.value))
+                matched++;
+        }
+        check(matched == int(states.size()), "tablebase gives back every state's value and cell");
+        read.close();
+        remove(path.c_str());
+    }
+
+      // Expected shots to sink the fleet under optimal play, worked out by
+      // hand for the smallest boards
+    void testSolverValues()
+    {
+        struct Case
+        {
+            int rows;
+            int cols;
+            vector<int> lengths;
+            double expected;
+        };
+        const Case cases[] = {
+            { 2, 3, { 2 }, 25.0 / 7 },
+            { 3, 3, { 3, 2 }, 6.63889 },
+            { 3, 3, { 2, 2 }, 6.25 },
+        };
+        for (const Case& c : cases)
+        {
+            Game g(c.rows, c.cols);
+            addShips(g, c.lengths);
+            OptimalSolver solver(g);
+            string name = "solver " + to_string(c.rows) + "x" + to_string(c.cols);
+            for (int len : c.lengths)
+                name += " " + to_string(len);
+            check(solver.solve(1), name + " solves");
+            check(fabs(solver.stats().expectedShots - c.expected) < 1e-4,
+                  name + " expects " + to_string(c.expected) + " shots, got " +
+                  to_string(solver.stats().expectedShots));
+        }
+    }
+}
+
+  // usage: tests
+  // Runs the round trips of the replay log and the tablebase and checks
+  // the solver against known values; exits nonzero if any check fails.
+int main()
+{
+    testReplayRoundTrip();
+    testTablebaseRoundTrip();
+    testSolverValues();
+    if (failures > 0)
+    {
+        cout << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "All checks passed" << endl;
+    return 0;
+}
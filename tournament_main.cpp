@@ -0,0 +1,242 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "Player.h"
+#include "Random.h"
+#include "Instrument.h"
+#include "OpeningBook.h"
+#include "Solver.h"
+#include "Strategies.h"
+#include "Tablebase.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void usage(const char* prog)
+    {
+        cerr << "usage: " << prog << " type1 type2 [games] [threads] [seed]\n"
+             << "       [--move-ms ms] [--game-ms ms] [--forfeit] [--record file]\n"
+             << "       [--csv file] [--batch] [--virtual] [--openings book]\n"
+             << "       [--cache-entries n] [--board RxC] [--ships l1,l2,...]\n"
+             << "       [--tablebase file]" << endl;
+    }
+
+      // Parse "RxC" into cfg's board size
+    bool parseBoard(const string& text, TournamentConfig& cfg)
+    {
+        istringstream in(text);
+        char x;
+        return (in >> cfg.rows >> x >> cfg.cols) && x == 'x' && cfg.rows > 0 && cfg.cols > 0;
+    }
+
+      // Parse comma-separated lengths into cfg's fleet
+    bool parseShips(const string& text, TournamentConfig& cfg)
+    {
+        istringstream in(text);
+        string len;
+        cfg.ships.clear();
+        while (getline(in, len, ','))
+        {
+            cfg.ships.push_back(atoi(len.c_str()));
+            if (cfg.ships.back() < 1)
+                return false;
+        }
+        return !cfg.ships.empty();
+    }
+}
+
+  // usage: tournament type1 type2 [games] [threads] [seed] [options]
+  // Plays games headless between two computer players and prints the tally.
+  //   --move-ms ms   time budget for each move
+  //   --game-ms ms   time budget for all of a player's moves in a game
+  //   --forfeit      a move over budget loses the shot, rather than being
+  //                  replaced by a random untried cell
+  //   --record file  append every game to a replay log (see replay)
+  //   --csv file     stream a line of results per game to a CSV file
+  //   --batch        play many games at once on the batch engine, if both
+  //                  types have batch versions and no other option is given
+  //   --virtual      call every player through the virtual Player interface,
+  //                  even built-in ones that could be called directly
+  //   --openings book  take opening lines from a book file (see openings)
+  //                  rather than computing them at startup
+  //   --cache-entries n  size of the transposition cache shared by the
+  //                  players (rounded up to a power of two)
+  //   --board RxC    play on an R-row, C-column board instead of 10x10
+  //   --ships l1,l2,...  play with ships of these lengths instead of the
+  //                  standard fleet, at most MAX_SHIPS of them; with a
+  //                  small board, this is how to give the optimal player
+  //                  a configuration it can solve
+  //   --tablebase file  map a tablebase of solved states (see tablebase),
+  //                  which the optimal, density and montecarlo players
+  //                  consult before their own strategies
+int main(int argc, char* argv[])
+{
+    TournamentConfig cfg;
+    vector<string> args;
+    for (int k = 1; k < argc; k++)
+    {
+        string arg = argv[k];
+        bool hasValue = (k + 1 < argc);
+        if (arg == "--move-ms" && hasValue)
+            cfg.moveMs = atof(argv[++k]);
+        else if (arg == "--game-ms" && hasValue)
+            cfg.gameMs = atof(argv[++k]);
+        else if (arg == "--forfeit")
+            cfg.overrunPolicy = OVERRUN_FORFEIT;
+        else if (arg == "--record" && hasValue)
+            cfg.recordPath = argv[++k];
+        else if (arg == "--csv" && hasValue)
+            cfg.resultsPath = argv[++k];
+        else if (arg == "--batch")
+            cfg.batch = true;
+        else if (arg == "--virtual")
+            cfg.staticDispatch = false;
+        else if (arg == "--cache-entries" && hasValue)
+            cfg.cacheEntries = strtoull(argv[++k], nullptr, 10);
+        else if (arg == "--board" && hasValue)
+        {
+            if (!parseBoard(argv[++k], cfg))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--ships" && hasValue)
+        {
+            if (!parseShips(argv[++k], cfg))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--tablebase" && hasValue)
+        {
+            if (!openTablebase(argv[++k]))
+            {
+                cerr << "Cannot read tablebase " << argv[k] << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--openings" && hasValue)
+        {
+            if (!loadOpeningBook(argv[++k]))
+            {
+                cerr << "Cannot read opening book " << argv[k] << endl;
+                return 1;
+            }
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else
+            args.push_back(arg);
+    }
+    if (args.size() < 2 || args.size() > 5)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    cfg.type1 = args[0];
+    cfg.type2 = args[1];
+    cfg.games = (args.size() > 2 ? atol(args[2].c_str()) : 1000);
+    cfg.threads = (args.size() > 3 ? atoi(args[3].c_str()) : int(thread::hardware_concurrency()));
+    if (cfg.threads < 1)
+        cfg.threads = 1;
+    cfg.seed = (args.size() > 4 ? strtoull(args[4].c_str(), nullptr, 10) : entropySeed());
+
+    if (cfg.ships.size() > size_t(MAX_SHIPS))
+    {
+        cerr << "Too many ships (at most " << MAX_SHIPS << ")" << endl;
+        return 1;
+    }
+    Game g(cfg.rows, cfg.cols);
+    if (!addTournamentShips(g, cfg))
+    {
+        cerr << "The fleet does not fit on a " << cfg.rows << "x" << cfg.cols << " board" << endl;
+        return 1;
+    }
+    for (const string& type : { cfg.type1, cfg.type2 })
+    {
+        unique_ptr<Player> p(createPlayer(type, type, g));
+        if (p == nullptr || p->isHuman())
+        {
+            cerr << "Player type " << type << " cannot play in a tournament" << endl;
+            return 1;
+        }
+        if (playingType(type, g) != type)
+            cout << type << ": board too big, playing " << playingType(type, g)
+                 << " instead" << '\n';
+    }
+    if (cfg.type1 == "optimal" || cfg.type2 == "optimal")
+    {
+          // Creating the players above solved the configuration, unless
+          // the tablebase has it
+        const OptimalSolver* solver = nullptr;
+        if (sharedTablebase().findConfig(g) >= 0)
+            cout << "Optimal solver: playing from the tablebase of "
+                 << sharedTablebase().states() << " states" << '\n';
+        else
+            solver = optimalSolver(g);
+        if (solver != nullptr)
+        {
+            const SolverStats& st = solver->stats();
+            cout << "Optimal solver: " << st.layouts << " layouts, " << st.states
+                 << " states in " << st.seconds << " s ("
+                 << (st.seconds > 0 ? st.states / st.seconds : 0) << " states/s), "
+                 << st.expectedShots << " expected shots" << '\n';
+        }
+        else if (sharedTablebase().findConfig(g) < 0)
+            cout << "Optimal solver: too big to solve, playing "
+                 << playingType("density", g) << " instead" << '\n';
+    }
+
+#ifdef BSIM_INSTRUMENT
+      // With instrumentation compiled in, BSIM_TRACE names a file for a
+      // Chrome trace of the last spans on each thread
+    const char* tracePath = getenv("BSIM_TRACE");
+    if (tracePath != nullptr)
+        setProbeTracing(true);
+#endif
+    TournamentResult r = runTournament(cfg);
+    cout << r.games << " games on " << cfg.threads << " threads in "
+         << r.seconds << " s (" << (r.seconds > 0 ? r.games / r.seconds : 0)
+         << " games/s), seed " << cfg.seed << (r.batched ? ", batched" : "") << '\n';
+    if (cfg.batch && !r.batched)
+        cout << "(played one game at a time: no batch version of these settings)" << '\n';
+    const string* types[2] = { &cfg.type1, &cfg.type2 };
+    for (int s = 0; s < 2; s++)
+    {
+        long played = r.games - r.failed;
+        cout << *types[s] << " " << s + 1 << ": " << r.wins[s] << " wins, "
+             << (played > 0 ? double(r.shots[s]) / played : 0) << " shots per game";
+        if (cfg.moveMs > 0 || cfg.gameMs > 0)
+            cout << ", " << r.overruns[s] << " moves over budget";
+        cout << '\n';
+    }
+    if (r.failed > 0)
+        cout << r.failed << " games could not be started" << '\n';
+    if (r.cache.lookups > 0)
+        cout << "Transposition cache of " << r.cache.entries << " entries: "
+             << r.cache.lookups << " lookups, " << r.cache.hits << " hits ("
+             << 100.0 * r.cache.hits / r.cache.lookups << "%), " << r.cache.stores
+             << " stores, " << r.cache.evictions << " evictions" << '\n';
+    if (!r.recordOk)
+        cerr << "Cannot write replay log " << cfg.recordPath << endl;
+    if (!r.resultsOk)
+        cerr << "Cannot write results file " << cfg.resultsPath << endl;
+#ifdef BSIM_INSTRUMENT
+    cout << '\n';
+    writeProbeReport(cout);
+    if (tracePath != nullptr && !writeChromeTrace(tracePath))
+        cerr << "Cannot write trace " << tracePath << endl;
+#endif
+}